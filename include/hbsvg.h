@@ -2,6 +2,7 @@
 #define HBSVG_H
 
 #include <math.h>
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
@@ -9,6 +10,10 @@
 #include "hbapi.h"
 #include "hbapierr.h"
 #include "hbapiitm.h"
+#include "hbthread.h"
+#include "hbvm.h"
+
+#include "hbsvg.ch"
 
 typedef enum   _bool bool;
 
@@ -18,13 +23,203 @@ enum _bool
    T = ( ! 0 )
 };
 
+typedef struct
+{
+   HB_I32 x0;
+   HB_I32 y0;
+   HB_I32 x1;
+   HB_I32 y1;
+} SVG_BOX;
+
+/* Bounding boxes of emitted elements and the packed Hilbert R-tree built over them */
+typedef struct
+{
+   SVG_BOX *items;      // recorded element boxes, in drawing order
+   HB_SIZE count;
+   HB_SIZE capacity;
+
+   SVG_BOX *nodes;      // leaves (sorted by Hilbert value) followed by each upper level
+   HB_U32 *indices;     // leaf: item number, node: position of its first child
+   HB_SIZE num_nodes;
+   HB_SIZE *level_bounds;
+   int num_levels;
+   bool dirty;
+} SVG_INDEX;
+
+/* Growable byte buffer */
+typedef struct
+{
+   char *data;
+   HB_SIZE len;
+   HB_SIZE capacity;
+} SVG_BUFFER;
+
+typedef struct
+{
+   SVG_BUFFER pending;  // output not yet written to the tile file
+   bool created;
+} SVG_TILE;
+
+/* Tile pyramid: every element is routed to the tiles its bounding box intersects */
+typedef struct
+{
+   char *prefix;
+   int width;
+   int height;
+   int tile_size;
+   int levels;          // level levels - 1 is full resolution, each lower level halves the scale
+   bool minify;
+   int *cols;
+   int *rows;
+   SVG_TILE **tiles;    // per level, cols * rows tiles in row-major order
+   HB_SIZE pending;     // bytes buffered across all tiles
+
+   SVG_BUFFER element;  // output of the element being written
+   SVG_BOX box;
+   bool bounded;        // F: the element goes to every tile (background, gradient definitions)
+   bool error;          // a tile could not be written
+} SVG_TILES;
+
+typedef void ( *SVG_WRITE_FUNC )( void *cargo, const char *data, HB_SIZE len );
+
+/* SVG template, memory-mapped or in memory */
+typedef struct
+{
+   const char *data;
+   HB_SIZE size;
+   bool mapped;         // data is a file mapping, released by svg_template_close()
+   HB_SIZE body;        // offset of the content of the outer <svg> element
+   bool empty;          // the outer element is <svg ... />
+   double width;        // outer width/height, 0 when missing or relative
+   double height;
+   double vb_x;
+   double vb_y;
+   double vb_w;
+   double vb_h;
+   bool has_viewbox;
+   SVG_BUFFER namespaces;  // xmlns:prefix declarations of the outer element
+} SVG_TEMPLATE;
+
+typedef struct _SVG_WRITER SVG_WRITER;
+typedef struct _SVG_RECORDER SVG_RECORDER;
+typedef struct _SVG_TEXT_CACHE SVG_TEXT_CACHE;
+
+/* Path built by svg_path_*(). Its bounding box is known only when it ends, so
+   with svg_init_tiled() the whole path stays in memory until svg_path_end();
+   split very long paths there to keep memory bounded. */
+typedef struct
+{
+   bool open;           // between svg_path_begin() and svg_path_end()
+   bool current;        // a current point exists
+   bool bounded;        // x0 .. y1 hold at least one point
+   bool drawn;          // a command was written to the d attribute
+   double x0;
+   double y0;
+   double x1;
+   double y1;
+   int stroke_width;
+   unsigned int stroke;
+   int fill;            // fill colour, -1 for none
+} SVG_PATH;
+
 typedef struct
 {
    FILE *file;
+   SVG_BUFFER out;      // formatted output not yet written to file, kept across pooled documents
+   bool error;          // a write to file failed
    int width;
    int height;
+   char *filename;
+   int flags;
+   SVG_INDEX *index;
+   SVG_TILES *tiles;
+   char scratch[ 8 ][ 48 ];   // formatted attribute values, reused round-robin
+   int scratch_next;
+   int imports;         // number of svg_import() calls, makes template ids unique
+   int linear_gradients;   // triangle gradients so far, their ids restart with every document
+   int radial_gradients;
+   int clip_paths;      // clipped line chart plot areas so far
+   SVG_PATH path;       // path being built by svg_path_*()
+   HB_U64 hash;         // calls so far, SVG_FLAG_CACHE
+   char *cache;         // cache directory, NULL when the document is written directly
+   HB_SIZE cache_limit; // bytes of cached output kept in memory, 0 for no limit
+   char *tempname;      // cached output moved out of memory
+   SVG_WRITER *writer;  // background writer, SVG_FLAG_ASYNC
+   HB_SIZE flush_size;  // out is written when it grows beyond this
+   SVG_RECORDER *recorder;   // calls written to <filename>.svgb, SVG_FLAG_RECORD
+   SVG_TEXT_CACHE *text_cache;   // widths of strings measured so far
 } SVG;
 
+/* hbsvgbuf.c */
+extern void svg_buffer_reserve( SVG_BUFFER *buffer, HB_SIZE size );
+extern void svg_buffer_append( SVG_BUFFER *buffer, const char *data, HB_SIZE len );
+extern void svg_buffer_vprintf( SVG_BUFFER *buffer, const char *format, va_list args );
+extern void svg_buffer_free( SVG_BUFFER *buffer );
+extern const char *svg_file_map( const char *filename, HB_SIZE *size );
+extern void svg_file_unmap( const char *data, HB_SIZE size );
+
+/* hbsvgimp.c */
+extern bool svg_template_open( SVG_TEMPLATE *tpl, const char *filename );
+extern bool svg_template_open_data( SVG_TEMPLATE *tpl, const char *data, HB_SIZE size );
+extern void svg_template_close( SVG_TEMPLATE *tpl );
+extern void svg_template_write( SVG_TEMPLATE *tpl, const char *prefix, SVG_WRITE_FUNC write, void *cargo );
+
+/* hbsvgcac.c */
+#define SVG_CACHE_SPILL  0x1000000   // default bytes of a cached document kept in memory
+
+extern HB_U64 svg_hash_u64( HB_U64 hash, HB_U64 value );
+extern HB_U64 svg_hash_bytes( HB_U64 hash, const void *data, HB_SIZE len );
+extern HB_U64 svg_hash_item( HB_U64 hash, PHB_ITEM pItem );
+extern void svg_cache_call( SVG *svg );
+extern void svg_cache_key( HB_U64 hash, char *key );
+extern void svg_cache_set_dir( const char *dir, HB_SIZE limit );
+extern char *svg_cache_dir( HB_SIZE *limit );
+extern void svg_cache_detach( const char *filename );
+extern bool svg_cache_spill( SVG *svg, bool force );
+extern bool svg_cache_close( SVG *svg );
+
+/* hbsvgdsm.c */
+extern HB_SIZE svg_downsample_lttb( const double *points, HB_SIZE count, HB_SIZE threshold, HB_SIZE *selected );
+extern HB_SIZE svg_downsample_minmax( const double *points, HB_SIZE count, HB_SIZE threshold, HB_SIZE *selected );
+
+/* hbsvgfit.c */
+extern HB_SIZE svg_fit_curve( const double *points, HB_SIZE count, double tolerance, double corner_angle, double **segments );
+
+/* hbsvgfnt.c */
+extern int svg_font_face( const char *family, int weight );
+extern HB_U32 svg_font_units( int face, const char *text, HB_SIZE len );
+extern double svg_text_measure( SVG *svg, const char *text, const char *font, int size, int weight );
+extern void svg_text_cache_free( SVG *svg );
+
+/* hbsvgidx.c */
+extern SVG_INDEX *svg_index_new( void );
+extern void svg_index_free( SVG_INDEX *index );
+extern void svg_index_add( SVG_INDEX *index, int x0, int y0, int x1, int y1 );
+extern void svg_index_build( SVG_INDEX *index );
+extern HB_SIZE svg_index_query( SVG_INDEX *index, int x0, int y0, int x1, int y1, HB_U32 **results );
+extern bool svg_index_save( SVG_INDEX *index, const char *filename );
+
+/* hbsvgmin.c */
+extern void svg_color_short( char *buffer, unsigned int color );
+
+/* hbsvgwrt.c */
+extern SVG_WRITER *svg_writer_new( FILE *file );
+extern void svg_writer_push( SVG_WRITER *writer, SVG_BUFFER *out );
+extern bool svg_writer_close( SVG_WRITER *writer );
+
+/* hbsvgrec.c */
+extern SVG_RECORDER *svg_recorder_new( const char *binfile, int width, int height, int flags );
+extern void svg_recorder_call( SVG_RECORDER *rec );
+extern void svg_recorder_template( SVG_RECORDER *rec, const char *data, HB_SIZE len );
+extern bool svg_recorder_close( SVG_RECORDER *rec );
+extern bool svg_replay_file( const char *binfile, const char *svgfile );
+
+/* hbsvgtil.c */
+extern SVG_TILES *svg_tiles_new( const char *prefix, int width, int height, int tile_size, int levels, bool minify );
+extern void svg_tiles_element( SVG_TILES *tiles, const SVG_BOX *box );
+extern void svg_tiles_bound( SVG_TILES *tiles, const SVG_BOX *box );
+extern bool svg_tiles_close( SVG_TILES *tiles );
+
 #define HB_ERR_ARGS() ( hb_errRT_BASE_SubstR( EG_ARG, 3012, NULL, HB_ERR_FUNCNAME, HB_ERR_ARGS_BASEPARAMS ) )
 
 #endif /* HBSVG_H */
\ No newline at end of file
@@ -7,6 +7,14 @@
 
 #include "hbsvg.h"
 
+#define SVG_POOL_SIZE   16
+#define SVG_FLUSH_SIZE  0x10000
+#define SVG_ASYNC_SIZE  0x100000
+#define SVG_CACHE_FORMAT 6       // part of every cache key; bump whenever the written SVG changes
+
+static bool svg_finish( SVG *svg );
+static void svg_free( SVG *svg );
+
 /* ------------------------------------------------------------------------- */
 // Garbage Collector SVG
 static HB_GARBAGE_FUNC( hb_svg_destructor )
@@ -15,6 +23,9 @@ static HB_GARBAGE_FUNC( hb_svg_destructor )
 
    if( *ppSVG )
    {
+      // Handle dropped without svg_close(), finish the document and release it
+      svg_finish( *ppSVG );
+      svg_free( *ppSVG );
       *ppSVG = NULL;
    }
 }
@@ -30,12 +41,29 @@ static SVG *hb_svg_Param( int iParam )
    SVG **ppSVG = ( SVG ** ) hb_parptrGC( &s_gcSVGFuncs, iParam );
 
    if( ppSVG && *ppSVG )
+   {
       return *ppSVG;
+   }
 
    hb_errRT_BASE( EG_ARG, 3012, NULL, HB_ERR_FUNCNAME, HB_ERR_ARGS_BASEPARAMS );
    return NULL;
 }
 
+/* Called by the drawing functions once their arguments are checked, so that
+   neither the cache key nor the recording covers queries or calls which raise
+   an argument error */
+static void svg_call( SVG *svg )
+{
+   if( svg->cache )
+   {
+      svg_cache_call( svg );
+   }
+   if( svg->recorder )
+   {
+      svg_recorder_call( svg->recorder );
+   }
+}
+
 static PHB_ITEM hb_svg_ItemPut( PHB_ITEM pItem, SVG *pSVG )
 {
    SVG **ppSVG = ( SVG ** ) hb_gcAllocate( sizeof( SVG * ), &s_gcSVGFuncs );
@@ -57,423 +85,735 @@ static void hb_svg_Return( SVG *pSVG )
 }
 
 /* ------------------------------------------------------------------------- */
-// static
-static void svg_line( SVG *svg, int x1, int y1, int x2, int y2, int stroke_width, unsigned int color )
+// Handle pool
+/* Finished handles keep their output buffer and are reused by the next svg_init() */
+static HB_CRITICAL_NEW( s_poolMtx );
+static SVG *s_pool[ SVG_POOL_SIZE ];
+static int s_poolCount = 0;
+static bool s_poolAtExit = F;
+
+static void svg_pool_exit( void *cargo )
 {
-   fprintf( svg->file, "<line x1=\"%d\" y1=\"%d\" x2=\"%d\" y2=\"%d\" style=\"stroke-width:%d; stroke:#%06x\" />\n", x1, y1, x2, y2, stroke_width, color );
-}
+   HB_SYMBOL_UNUSED( cargo );
 
-static void svg_text( SVG *svg, int x, int y, const char *text, const char *font, int size, int font_weight, unsigned int color )
-{
-   fprintf( svg->file, "<text x=\"%d\" y=\"%d\" font-family=\"%s\" font-size=\"%d\" font-weight=\"%d\" fill=\"#%06x\">%s</text>\n", x, y, font, size, font_weight, color & 0xFFFFFF, text );
+   hb_threadEnterCriticalSection( &s_poolMtx );
+   while( s_poolCount > 0 )
+   {
+      SVG *svg = s_pool[ --s_poolCount ];
+
+      svg_buffer_free( &svg->out );
+      hb_xfree( svg );
+   }
+   hb_threadLeaveCriticalSection( &s_poolMtx );
 }
 
-static void svg_arrow( SVG *svg, int x1, int y1, int x2, int y2, int stroke_width, unsigned int color )
+static SVG *svg_new( void )
 {
-   // Draw a line from ( x1, y1 ) to ( x2, y2 )
-   svg_line( svg, x1, y1, x2, y2, stroke_width, color );
-
-   // Calculate the angle of the line
-   double angle = atan2( ( double )( y2 - y1 ), ( double )( x2 - x1 ) );
-
-   // Length of the arrow head
-   int arrow_length = 10;
+   SVG *svg = NULL;
+   SVG_BUFFER out;
 
-   // Angles for the arrow heads
-   double angle1 = angle + M_PI / 6.0;
-   double angle2 = angle - M_PI / 6.0;
+   hb_threadEnterCriticalSection( &s_poolMtx );
+   if( s_poolCount > 0 )
+   {
+      svg = s_pool[ --s_poolCount ];
+   }
+   hb_threadLeaveCriticalSection( &s_poolMtx );
 
-   // Calculate the endpoints for the arrow head
-   int x3 = x2 - ( int ) ( arrow_length * cos( angle1 ) );
-   int y3 = y2 - ( int ) ( arrow_length * sin( angle1 ) );
+   if( svg && svg->out.data )
+   {
+      out = svg->out;
+      out.len = 0;
+   }
+   else
+   {
+      if( svg == NULL )
+      {
+         svg = ( SVG * ) hb_xgrab( sizeof( SVG ) );
+      }
+      memset( &out, 0, sizeof( SVG_BUFFER ) );
+      svg_buffer_reserve( &out, SVG_FLUSH_SIZE + 1024 );
+   }
 
-   int x4 = x2 - ( int ) ( arrow_length * cos( angle2 ) );
-   int y4 = y2 - ( int ) ( arrow_length * sin( angle2 ) );
+   memset( svg, 0, sizeof( SVG ) );
+   svg->out = out;
+   svg->flush_size = SVG_FLUSH_SIZE;
 
-   // Draw the "head" of the arrow
-   svg_line( svg, x2, y2, x3, y3, stroke_width, color );
-   svg_line( svg, x2, y2, x4, y4, stroke_width, color );
+   return svg;
 }
 
-/* ------------------------------------------------------------------------- */
-// API functions
-/* svg_init( <cFileName>, <nWidth>, <nHeight> ) --> <pHandle> | NIL */
-HB_FUNC( SVG_INIT )
+static void svg_free( SVG *svg )
 {
-   SVG *svg = hb_xgrab( sizeof( SVG ) );
-   if( svg == NULL )
+   hb_threadEnterCriticalSection( &s_poolMtx );
+   if( ! s_poolAtExit )
    {
-      fprintf( stderr, "Error: Could not allocate memory for SVG structure.\n" );
-      hb_ret(); // Return NIL to indicate failure
+      s_poolAtExit = T;
+      hb_vmAtExit( svg_pool_exit, NULL );
    }
-
-   const char *filename = hb_parc( 1 );
-
-   if( filename )
+   if( s_poolCount < SVG_POOL_SIZE )
    {
-      svg->file = fopen( filename, "w" );
-      if( svg->file == NULL )
+      // A cached document may have grown the buffer far beyond the flush size
+      if( svg->out.capacity > SVG_FLUSH_SIZE * 4 )
       {
-         fprintf( stderr, "Error: Could not open file '%s' for writing.\n", filename );
-         free( svg ); // Don't forget to free the previously allocated memory
-         hb_ret();    // Return NIL to indicate failure
+         svg_buffer_free( &svg->out );
       }
-
-      svg->width = hb_parni( 2 );
-      svg->height = hb_parni( 3 );
-
-      fprintf( svg->file, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n" );
-      fprintf( svg->file, "<!DOCTYPE svg PUBLIC \"-//W3C//DTD SVG 1.1//EN\" " );
-      fprintf( svg->file, "\"http://www.w3.org/Graphics/SVG/1.1/DTD/svg11.dtd\">\n" );
-      fprintf( svg->file, "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%d\" height=\"%d\" viewBox=\"0 0 %d %d\">\n", svg->width, svg->height, svg->width, svg->height );
-
-      hb_svg_Return( svg );
+      s_pool[ s_poolCount++ ] = svg;
+      svg = NULL;
    }
-   else
+   hb_threadLeaveCriticalSection( &s_poolMtx );
+
+   if( svg )
    {
-      HB_ERR_ARGS();
+      svg_buffer_free( &svg->out );
+      hb_xfree( svg );
    }
 }
 
-/* svg_set_background( <pHandle>, <nHexColor> ) --> NIL */
-HB_FUNC( SVG_SET_BACKGROUND )
+/* ------------------------------------------------------------------------- */
+// static
+static void svg_flush( SVG *svg )
 {
-   SVG *svg = hb_svg_Param( 1 );
-
-   if( svg )
+   if( svg->out.len && svg->writer )
    {
-      unsigned long hexColor = hb_parnl( 2 );
-
-      if( hexColor <= 0xFFFFFF )
+      // The writer thread takes the buffer, formatting goes on in another one
+      svg_writer_push( svg->writer, &svg->out );
+   }
+   else if( svg->out.len )
+   {
+      // Cached documents stay in memory until they outgrow the spill size
+      if( svg->file == NULL && ! svg_cache_spill( svg, F ) )
       {
-         // No alpha channel, use full opacity
-         fprintf( svg->file, "<rect x=\"0\" y=\"0\" width=\"%d\" height=\"%d\" fill=\"#%06lX\" fill-opacity=\"1\"/>\n", svg->width, svg->height, hexColor );
+         if( svg->error )
+         {
+            svg->out.len = 0;
+         }
+         return;
       }
-      else if( hexColor <= 0xFFFFFFFF )
+
+      if( fwrite( svg->out.data, 1, svg->out.len, svg->file ) != svg->out.len )
       {
-         // Alpha channel is available
-         double a = ( hexColor & 0xFF ) / 255.0;
-         unsigned int color = ( hexColor >> 8 ) & 0xFFFFFF;
-         fprintf( svg->file, "<rect x=\"0\" y=\"0\" width=\"%d\" height=\"%d\" fill=\"#%06X\" fill-opacity=\"%f\"/>\n", svg->width, svg->height, color, a );
+         svg->error = T;
       }
-      else
+      svg->out.len = 0;
+   }
+}
+
+static void svg_write( SVG *svg, const char *data, HB_SIZE len )
+{
+   if( svg->tiles )
+   {
+      svg_buffer_append( &svg->tiles->element, data, len );
+   }
+   else if( len >= svg->flush_size && svg->file && ! svg->writer )
+   {
+      svg_flush( svg );
+      if( fwrite( data, 1, len, svg->file ) != len )
       {
-         fprintf( stderr, "Invalid hex value passed\n" );
+         svg->error = T;
       }
    }
    else
    {
-      HB_ERR_ARGS();
+      svg_buffer_append( &svg->out, data, len );
+      if( svg->out.len >= svg->flush_size )
+      {
+         svg_flush( svg );
+      }
    }
 }
 
-/* svg_close( <pHandle> ) --> <lOK> */
-HB_FUNC( SVG_CLOSE )
+static void svg_write_func( void *cargo, const char *data, HB_SIZE len )
 {
-   SVG *svg = hb_svg_Param( 1 );
+   svg_write( ( SVG * ) cargo, data, len );
+}
 
-   if( svg )
+/* Format of a call site: the compact one in minified output */
+#define SVG_FMT( svg, format, minified )  ( ( ( svg )->flags & SVG_FLAG_MINIFY ) ? ( minified ) : ( format ) )
+
+static void svg_printf( SVG *svg, const char *format, ... )
+{
+   va_list args;
+
+   va_start( args, format );
+   if( svg->tiles )
    {
-      fprintf( svg->file, "</svg>" );
-      fclose( svg->file );
-      hb_xfree( svg );
-      hb_retl( HB_TRUE );
+      svg_buffer_vprintf( &svg->tiles->element, format, args );
    }
    else
    {
-      fprintf( stderr, "Error: svg_close called with NULL SVG pointer.\n" );
-      HB_ERR_ARGS();
+      svg_buffer_vprintf( &svg->out, format, args );
+      if( svg->out.len >= svg->flush_size )
+      {
+         svg_flush( svg );
+      }
    }
+   va_end( args );
 }
 
-/* svg_rect( <pHandle>, <nX>, <nY>, <nWidth>, <nHeight>, <nStroke_width>, <nColor> ) --> NIL */
-HB_FUNC( SVG_RECT )
+static char *svg_scratch( SVG *svg )
 {
-   SVG *svg = hb_svg_Param( 1 );
+   char *buffer = svg->scratch[ svg->scratch_next ];
 
-   if( svg )
-   {
-      int x = hb_parni( 2 );
-      int y = hb_parni( 3 );
-      int width = hb_parni( 4 );
-      int height = hb_parni( 5 );
-      int stroke_width = hb_parni( 6 );
-      unsigned int color = hb_parni( 7 );
+   svg->scratch_next = ( svg->scratch_next + 1 ) % HB_SIZEOFARRAY( svg->scratch );
+   return buffer;
+}
 
-      fprintf( svg->file, "<rect x=\"%d\" y=\"%d\" width=\"%d\" height=\"%d\" stroke-width=\"%d\" stroke=\"#%06x\" fill=\"none\"/>\n", x, y, width, height, stroke_width, color );
+/* Colour value for fill/stroke attributes */
+static const char *svg_color( SVG *svg, unsigned int color )
+{
+   char *buffer = svg_scratch( svg );
+
+   if( svg->flags & SVG_FLAG_MINIFY )
+   {
+      svg_color_short( buffer, color );
    }
    else
    {
-      HB_ERR_ARGS();
+      sprintf( buffer, "#%06x", color );
    }
+
+   return buffer;
 }
 
-/* svg_filled_rect( <pHandle>, <nX>, <nY>, <nWidth>, <nHeight>, <nColor> ) --> NIL */
-HB_FUNC( SVG_FILLED_RECT )
+/* ' name="value"', or nothing when minified and the value is the SVG default */
+static const char *svg_attr( SVG *svg, const char *name, int value, int default_value )
 {
-   SVG *svg = hb_svg_Param( 1 );
+   char *buffer = svg_scratch( svg );
 
-   if( svg )
+   if( ( svg->flags & SVG_FLAG_MINIFY ) && value == default_value )
    {
-      int x = hb_parni( 2 );
-      int y = hb_parni( 3 );
-      int width = hb_parni( 4 );
-      int height = hb_parni( 5 );
-      unsigned int color = hb_parni( 6 );
-
-      fprintf( svg->file, "<rect x=\"%d\" y=\"%d\" width=\"%d\" height=\"%d\" fill=\"#%06x\"/>\n", x, y, width, height, color );
+      buffer[ 0 ] = '\0';
    }
    else
    {
-      HB_ERR_ARGS();
+      snprintf( buffer, sizeof( svg->scratch[ 0 ] ), " %s=\"%d\"", name, value );
    }
+
+   return buffer;
 }
 
-/* svg_triangle( <pHandle>, <nX1>, <nY1>, <nX2>, <nY2>, <nX3>, <nY3>, <nStroke_width>, <nColor> ) --> NIL */
-HB_FUNC( SVG_TRIANGLE )
+/* Ends the path opened by svg_path_begin(); its box is known only now */
+static void svg_path_finish( SVG *svg )
 {
-   SVG *svg = hb_svg_Param( 1 );
+   SVG_PATH *path = &svg->path;
 
-   if( svg )
+   path->open = F;
+
+   if( path->bounded && ( svg->index || svg->tiles ) )
    {
-      int x1 = hb_parni( 2 );
-      int y1 = hb_parni( 3 );
-      int x2 = hb_parni( 4 );
-      int y2 = hb_parni( 5 );
-      int x3 = hb_parni( 6 );
-      int y3 = hb_parni( 7 );
-      int stroke_width = hb_parni( 8 );
-      unsigned int color = hb_parni( 9 );
+      SVG_BOX box;
 
-      fprintf( svg->file, "<polygon points=\"%d,%d %d,%d %d,%d\" stroke-width=\"%d\" stroke=\"#%06x\" fill=\"none\"/>\n", x1, y1, x2, y2, x3, y3, stroke_width, color );
+      box.x0 = ( int ) floor( path->x0 ) - path->stroke_width / 2;
+      box.y0 = ( int ) floor( path->y0 ) - path->stroke_width / 2;
+      box.x1 = ( int ) ceil( path->x1 ) + path->stroke_width / 2;
+      box.y1 = ( int ) ceil( path->y1 ) + path->stroke_width / 2;
+
+      if( svg->index )
+      {
+         svg_index_add( svg->index, box.x0, box.y0, box.x1, box.y1 );
+      }
+      if( svg->tiles )
+      {
+         svg_tiles_bound( svg->tiles, &box );
+      }
    }
-   else
+
+   svg_printf( svg, SVG_FMT( svg, "\" stroke=\"%s\"%s fill=\"%s\"/>\n", "\" stroke=\"%s\"%s fill=\"%s\"/>" ), svg_color( svg, path->stroke ), svg_attr( svg, "stroke-width", path->stroke_width, 1 ),
+               path->fill < 0 ? "none" : svg_color( svg, ( unsigned int ) path->fill ) );
+}
+
+/* Space between path commands, nothing before the first one */
+static const char *svg_path_separator( SVG_PATH *path )
+{
+   if( path->drawn )
    {
-      HB_ERR_ARGS();
+      return " ";
    }
+
+   path->drawn = T;
+   return "";
 }
-/* svg_filled_triangle( <pHandle>, <nX1>, <nY1>, <nX2>, <nY2>, <nX3>, <nY3>, <nColor> ) --> NIL */
-HB_FUNC( SVG_FILLED_TRIANGLE )
-{
-   SVG *svg = hb_svg_Param( 1 );
 
-   if( svg )
+static void svg_path_extend( SVG_PATH *path, double x, double y )
+{
+   if( ! path->bounded )
    {
-      int x1 = hb_parni( 2 );
-      int y1 = hb_parni( 3 );
-      int x2 = hb_parni( 4 );
-      int y2 = hb_parni( 5 );
-      int x3 = hb_parni( 6 );
-      int y3 = hb_parni( 7 );
-      unsigned int color = hb_parni( 8 );
-
-      fprintf( svg->file, "<polygon points=\"%d,%d %d,%d %d,%d\" fill=\"#%06x\"/>\n", x1, y1, x2, y2, x3, y3, color );
+      path->x0 = path->x1 = x;
+      path->y0 = path->y1 = y;
+      path->bounded = T;
    }
    else
    {
-      HB_ERR_ARGS();
+      if( x < path->x0 ) path->x0 = x;
+      if( x > path->x1 ) path->x1 = x;
+      if( y < path->y0 ) path->y0 = y;
+      if( y > path->y1 ) path->y1 = y;
    }
 }
 
-/* svg_circle( <pHandle>, <nCx>, <nCy>, <nR>, <nStroke_width>, <nColor> ) --> NIL */
-HB_FUNC( SVG_CIRCLE )
+/* Bounding box of the element about to be written */
+static void svg_bbox( SVG *svg, int x0, int y0, int x1, int y1 )
 {
-   SVG *svg = hb_svg_Param( 1 );
-
-   if( svg )
+   // A path still being built ends where the next element starts
+   if( svg->path.open )
    {
-      int cx = hb_parni( 2 );
-      int cy = hb_parni( 3 );
-      int r = hb_parni( 4 );
-      int stroke_width = hb_parni( 5 );
-      unsigned int color = hb_parni( 6 );
+      svg_path_finish( svg );
+   }
 
-      fprintf( svg->file, "<circle cx=\"%d\" cy=\"%d\" r=\"%d\" stroke-width=\"%d\" stroke=\"#%06x\" fill=\"none\"/>\n", cx, cy, r, stroke_width, color );
+   if( svg->index )
+   {
+      svg_index_add( svg->index, x0, y0, x1, y1 );
    }
-   else
+
+   if( svg->tiles )
    {
-      HB_ERR_ARGS();
+      SVG_BOX box;
+
+      box.x0 = x0 < x1 ? x0 : x1;
+      box.y0 = y0 < y1 ? y0 : y1;
+      box.x1 = x0 < x1 ? x1 : x0;
+      box.y1 = y0 < y1 ? y1 : y0;
+
+      svg_tiles_element( svg->tiles, &box );
    }
 }
 
-/* svg_filled_circle( <pHandle>, <nCx>, <nCy>, <nR>, <nColor> ) --> NIL */
-HB_FUNC( SVG_FILLED_CIRCLE )
+/* The output about to be written is not bound to an area of the canvas */
+static void svg_bbox_none( SVG *svg )
 {
-   SVG *svg = hb_svg_Param( 1 );
-
-   if( svg )
+   if( svg->path.open )
    {
-      int cx = hb_parni( 2 );
-      int cy = hb_parni( 3 );
-      int r = hb_parni( 4 );
-      unsigned int color = hb_parni( 5 );
-
-      fprintf( svg->file, "<circle cx=\"%d\" cy=\"%d\" r=\"%d\" fill=\"#%06x\"/>\n", cx, cy, r, color );
+      svg_path_finish( svg );
    }
-   else
+
+   if( svg->tiles )
    {
-      HB_ERR_ARGS();
+      svg_tiles_element( svg->tiles, NULL );
    }
 }
 
-/* svg_line( <pHandle>, <nX1>, <nY1>, <nX2>, <nY2>, <nStroke_width>, <nColor> ) --> NIL */
-HB_FUNC( SVG_LINE )
+static void svg_bbox_points( SVG *svg, const int *points, int count, int stroke_width )
 {
-   SVG *svg = hb_svg_Param( 1 );
-
-   if( svg )
+   if( ( svg->index || svg->tiles ) && count >= 2 )
    {
-      int x1 = hb_parni( 2 );
-      int y1 = hb_parni( 3 );
-      int x2 = hb_parni( 4 );
-      int y2 = hb_parni( 5 );
-      int stroke_width = hb_parni( 6 );
-      unsigned int color = hb_parni( 7 );
+      int x0 = points[ 0 ], y0 = points[ 1 ], x1 = x0, y1 = y0;
 
-      svg_line( svg, x1, y1, x2, y2, stroke_width, color );
-   }
-   else
-   {
-      HB_ERR_ARGS();
+      for( int i = 2; i + 1 < count; i += 2 )
+      {
+         if( points[ i ] < x0 ) x0 = points[ i ];
+         if( points[ i ] > x1 ) x1 = points[ i ];
+         if( points[ i + 1 ] < y0 ) y0 = points[ i + 1 ];
+         if( points[ i + 1 ] > y1 ) y1 = points[ i + 1 ];
+      }
+
+      svg_bbox( svg, x0 - stroke_width / 2, y0 - stroke_width / 2, x1 + stroke_width / 2, y1 + stroke_width / 2 );
    }
 }
 
-/* svg_polyline( <pHandle>, <aPoints>, <nPint_count>, <nStroke_width>, <nColor> ) --> NIL */
-HB_FUNC( SVG_POLYLINE )
+/* Numeric option of a style/options hash, default_value when missing */
+static int svg_hash_ni( PHB_ITEM pHash, const char *key, int default_value )
 {
-   SVG *svg = hb_svg_Param( 1 );
-   PHB_ITEM pItem;
+   PHB_ITEM pValue = pHash ? hb_hashGetCItemPtr( pHash, key ) : NULL;
 
-   if( svg && ( pItem = hb_param( 2, HB_IT_ARRAY ) ) != NULL )
-   {
-      int point_count = hb_parni( 3 );
-      int stroke_width = hb_parni( 4 );
-      unsigned int color = hb_parni( 5 );
+   return pValue && HB_IS_NUMERIC( pValue ) ? hb_itemGetNI( pValue ) : default_value;
+}
 
-      fprintf( svg->file, "<polyline points=\"" );
+static double svg_hash_nd( PHB_ITEM pHash, const char *key, double default_value )
+{
+   PHB_ITEM pValue = pHash ? hb_hashGetCItemPtr( pHash, key ) : NULL;
 
-      point_count = ( int ) hb_arrayLen( pItem );
-      int *points = NULL;
+   return pValue && HB_IS_NUMERIC( pValue ) ? hb_itemGetND( pValue ) : default_value;
+}
 
-      if( point_count )
-      {
-         points = ( int * ) hb_xgrab( point_count * sizeof( int ) );
-      }
+/* Points given as a flat array { x1, y1, x2, y2, ... } or as a packed string
+   of 32-bit little-endian x, y pairs ( L2Bin( x ) + L2Bin( y ) + ... ).
+   Returns NULL when the item is neither; otherwise *count is the number
+   of points and the result must be released with hb_xfree(). */
+static double *svg_item_points( PHB_ITEM pItem, HB_SIZE *count )
+{
+   double *points;
 
-      // Retrieving elements from the Harbour array into the points array
-      for( int i = 0; i < point_count; ++i )
+   *count = 0;
+
+   if( pItem == NULL )
+      return NULL;
+
+   if( HB_IS_ARRAY( pItem ) )
+   {
+      *count = hb_arrayLen( pItem ) / 2;
+      points = ( double * ) hb_xgrab( ( *count * 2 + 1 ) * sizeof( double ) );
+
+      for( HB_SIZE i = 0; i < *count * 2; ++i )
       {
-         points[ i ] = hb_arrayGetNI( pItem, ( HB_SIZE ) i + 1 );
+         points[ i ] = hb_arrayGetND( pItem, i + 1 );
       }
+   }
+   else if( HB_IS_STRING( pItem ) )
+   {
+      const char *data = hb_itemGetCPtr( pItem );
 
-      for( int i = 0; i < point_count; i += 2 )
+      *count = hb_itemGetCLen( pItem ) / 8;
+      points = ( double * ) hb_xgrab( ( *count * 2 + 1 ) * sizeof( double ) );
+
+      for( HB_SIZE i = 0; i < *count * 2; ++i )
       {
-         fprintf( svg->file, "%d,%d ", points[ i ], points[ i + 1 ] );
+         points[ i ] = HB_GET_LE_INT32( data + i * 4 );
       }
+   }
+   else
+   {
+      return NULL;
+   }
 
-      fprintf( svg->file, "\" stroke-width=\"%d\" stroke=\"#%06x\" fill=\"none\"/>\n", stroke_width, color );
+   return points;
+}
 
-      if( points )
-      {
-         hb_xfree( points );
-      }
+static double *svg_param_points( int iParam, HB_SIZE *count )
+{
+   return svg_item_points( hb_param( iParam, HB_IT_ARRAY | HB_IT_STRING ), count );
+}
+
+static void svg_line( SVG *svg, int x1, int y1, int x2, int y2, int stroke_width, unsigned int color )
+{
+   if( svg->flags & SVG_FLAG_MINIFY )
+   {
+      svg_printf( svg, "<line x1=\"%d\" y1=\"%d\" x2=\"%d\" y2=\"%d\"%s stroke=\"%s\"/>", x1, y1, x2, y2, svg_attr( svg, "stroke-width", stroke_width, 1 ), svg_color( svg, color ) );
    }
    else
    {
-      HB_ERR_ARGS();
+      svg_printf( svg, "<line x1=\"%d\" y1=\"%d\" x2=\"%d\" y2=\"%d\" style=\"stroke-width:%d; stroke:%s\" />\n", x1, y1, x2, y2, stroke_width, svg_color( svg, color ) );
    }
 }
-/* svg_arrow( <pHandle>, <nX1>, <nY1>, <nX2>, <nY2>, <nStroke_width>, <nColor> ) --> NIL */
-HB_FUNC( SVG_ARROW )
+
+static void svg_text( SVG *svg, int x, int y, const char *text, const char *font, int size, int font_weight, unsigned int color )
 {
-   SVG *svg = hb_svg_Param( 1 );
-   int x1 = hb_parni( 2 );
-   int y1 = hb_parni( 3 );
-   int x2 = hb_parni( 4 );
-   int y2 = hb_parni( 5 );
-   int stroke_width = hb_parni( 6 );
-   unsigned int color = hb_parni( 7 );
+   svg_printf( svg, SVG_FMT( svg, "<text x=\"%d\" y=\"%d\" font-family=\"%s\" font-size=\"%d\"%s fill=\"%s\">%s</text>\n", "<text x=\"%d\" y=\"%d\" font-family=\"%s\" font-size=\"%d\"%s fill=\"%s\">%s</text>" ), x, y, font, size, svg_attr( svg, "font-weight", font_weight, 400 ), svg_color( svg, color & 0xFFFFFF ), text );
+}
 
-   if( svg )
+/* Left end of text of the given width aligned at x */
+static int svg_align_x( int x, double width, int align )
+{
+   if( align == SVG_ALIGN_CENTER )
    {
-      svg_arrow( svg, x1, y1, x2, y2, stroke_width, color );
+      return x - ( int ) lround( width / 2 );
+   }
+   if( align == SVG_ALIGN_RIGHT )
+   {
+      return x - ( int ) lround( width );
+   }
+   return x;
+}
+
+/* Axis label in Arial 12, aligned at x by its measured width */
+static void svg_label( SVG *svg, int x, int y, const char *label, int align, unsigned int color )
+{
+   double width = svg_text_measure( svg, label, "Arial", 12, 400 );
+
+   svg_text( svg, svg_align_x( x, width, align ), y, label, "Arial", 12, 400, color );
+}
+
+static void svg_arrow( SVG *svg, int x1, int y1, int x2, int y2, int stroke_width, unsigned int color )
+{
+   // Draw a line from ( x1, y1 ) to ( x2, y2 )
+   svg_line( svg, x1, y1, x2, y2, stroke_width, color );
+
+   // Calculate the angle of the line
+   double angle = atan2( ( double )( y2 - y1 ), ( double )( x2 - x1 ) );
+
+   // Length of the arrow head
+   int arrow_length = 10;
+
+   // Angles for the arrow heads
+   double angle1 = angle + M_PI / 6.0;
+   double angle2 = angle - M_PI / 6.0;
+
+   // Calculate the endpoints for the arrow head
+   int x3 = x2 - ( int ) ( arrow_length * cos( angle1 ) );
+   int y3 = y2 - ( int ) ( arrow_length * sin( angle1 ) );
+
+   int x4 = x2 - ( int ) ( arrow_length * cos( angle2 ) );
+   int y4 = y2 - ( int ) ( arrow_length * sin( angle2 ) );
+
+   // Draw the "head" of the arrow
+   svg_line( svg, x2, y2, x3, y3, stroke_width, color );
+   svg_line( svg, x2, y2, x4, y4, stroke_width, color );
+}
+
+/* Axis label, integral values without decimals */
+static void svg_tick_label( char *label, double num )
+{
+   if( num == floor( num ) && fabs( num ) < 1e15 )
+   {
+      sprintf( label, "%.0f", num );
    }
    else
    {
-      HB_ERR_ARGS();
+      sprintf( label, "%g", num );
    }
 }
 
-/* svg_numbered_arrow( <pHandle>, <nX1>, <nY1>, <nX2>, <nY2>, <nStroke_width>, <nStart_num>, <nEnd_num>, <nStep>, <nColor> ) --> NIL */
-HB_FUNC( SVG_NUMBERED_ARROW )
+/* Tick marks and labels along a horizontal axis, num_labels values from start by step */
+static void svg_ticks_x( SVG *svg, int x1, int y1, int x2, double start, double step, int num_labels, unsigned int color )
 {
-   SVG *svg = hb_svg_Param( 1 );
-   int x1 = hb_parni( 2 );
-   int y1 = hb_parni( 3 );
-   int x2 = hb_parni( 4 );
-   int y2 = hb_parni( 5 );
-   int stroke_width = hb_parni( 6 );
-   int start_num = hb_parni( 7 );
-   int end_num = hb_parni( 8 );
-   int step = hb_parni( 9 );
-   unsigned int color = hb_parni( 10 );
+   // Labels are centred below their tick marks
+   int label_offset_y = 15;
 
-   if( svg )
+   float dx = ( x2 - x1 ) / ( float ) ( num_labels - 1 );
+   for( int i = 0; i < num_labels; ++i )
    {
-      // Drawing an arrow
-      svg_arrow( svg, x1, y1, x2, y2, stroke_width, color );
+      int x = x1 + dx * i;
+      int y = y1;
+      double num = start + step * i;
+      char label[ 32 ];
 
-      // Determining the number of labels on the arrow
-      int num_labels = ( end_num - start_num ) / step + 1;
+      if( fabs( num ) < fabs( step ) * 1e-9 )
+      {
+         num = 0;
+      }
+      svg_tick_label( label, num );
 
-      // Determining the spacing between labels on the arrow
-      float dx = ( x2 - x1 ) / ( float ) ( num_labels - 1 );
-      float dy = ( y2 - y1 ) / ( float ) ( num_labels - 1 );
+      // Draw tick mark for horizontal arrow
+      int tick_length = (i % 5 == 0) ? 10 : 5; // Every fifth tick mark is longer
+      svg_line(svg, x, y + tick_length, x, y, 1, color);
 
-      // If the arrow is vertical, adjust the label positions
-      int label_offset_x = 0;
-      int label_offset_y = 15;
-      if( x1 == x2 )
+      svg_label( svg, x, y + label_offset_y, label, SVG_ALIGN_CENTER, color );
+   }
+}
+
+/* Tick marks and labels along a vertical axis going up from y1 to y3; skip_zero leaves
+   the 0 label to the horizontal axis when both share their origin */
+static void svg_ticks_y( SVG *svg, int x1, int y1, int y3, double start, double step, int num_labels, bool skip_zero, unsigned int color )
+{
+   // Labels end label_gap units left of the axis
+   int label_gap = 7;
+
+   float dy = ( y1 - y3 ) / ( float ) ( num_labels - 1 );
+   for( int i = 0; i < num_labels; ++i )
+   {
+      int x = x1;
+      int y = y1 - dy * i;
+      double num = start + step * i;
+      char label[ 32 ];
+
+      if( fabs( num ) < fabs( step ) * 1e-9 )
       {
-         label_offset_x = -20;  // Start with a default offset
-         label_offset_y = 0;
+         num = 0;
       }
+      svg_tick_label( label, num );
 
-      // Adding labels and tick marks
-      for( int i = 0; i < num_labels; ++i )
+      // Draw tick mark for vertical arrow
+      int tick_length = (i % 5 == 0) ? 10 : 5; // Every fifth tick mark is longer
+      svg_line(svg, x - tick_length, y, x, y, 1, color);
+
+      if( num != 0 || ! skip_zero )
       {
-         int x = x1 + dx * i;
-         int y = y1 + dy * i;
-         int num = start_num + step * i;
-         char label[ 10 ];
-         sprintf( label, "%d", num );
+         svg_label( svg, x - label_gap, y, label, SVG_ALIGN_RIGHT, color );
+      }
+   }
+}
 
-         // Draw tick mark
-         int tick_length = ( i % 5 == 0 ) ? 10 : 5; // Every fifth tick mark is longer
-         if( x1 == x2 )
+/* Returns the ids of indexed elements intersecting the box as a Harbour array */
+static void svg_index_return( SVG *svg, int x0, int y0, int x1, int y1 )
+{
+   HB_U32 *ids = NULL;
+   HB_SIZE count = 0;
+
+   if( svg->index )
+   {
+      count = svg_index_query( svg->index, x0, y0, x1, y1, &ids );
+   }
+
+   PHB_ITEM pArray = hb_itemArrayNew( count );
+
+   for( HB_SIZE i = 0; i < count; ++i )
+   {
+      hb_arraySetNL( pArray, i + 1, ( long ) ids[ i ] );
+   }
+
+   if( ids )
+   {
+      hb_xfree( ids );
+   }
+
+   hb_itemReturnRelease( pArray );
+}
+
+/* Completes the document and releases everything but the pooled SVG structure */
+static bool svg_finish( SVG *svg )
+{
+   bool ok = T;
+
+   if( svg->path.open )
+   {
+      svg_path_finish( svg );
+   }
+
+   if( svg->tiles )
+   {
+      ok = svg_tiles_close( svg->tiles );
+      svg->tiles = NULL;
+   }
+   else if( svg->cache )
+   {
+      svg_printf( svg, "</svg>" );
+      ok = svg_cache_close( svg );
+   }
+   else if( svg->file )
+   {
+      svg_printf( svg, "</svg>" );
+      svg_flush( svg );
+      if( svg->writer )
+      {
+         // Waits for the queued output
+         if( ! svg_writer_close( svg->writer ) )
          {
-            svg_line( svg, x - tick_length, y, x, y, 1, color );
+            svg->error = T;
          }
-         else
+         svg->writer = NULL;
+      }
+      if( fclose( svg->file ) != 0 || svg->error )
+      {
+         ok = F;
+      }
+      svg->file = NULL;
+   }
+
+   if( svg->recorder )
+   {
+      if( ! svg_recorder_close( svg->recorder ) )
+      {
+         ok = F;
+      }
+      svg->recorder = NULL;
+   }
+
+   if( svg->index )
+   {
+      // The index is saved next to the document as <cFileName>.idx
+      char *idxname = ( char * ) hb_xgrab( strlen( svg->filename ) + 5 );
+      strcpy( idxname, svg->filename );
+      strcat( idxname, ".idx" );
+
+      if( ! svg_index_save( svg->index, idxname ) )
+      {
+         ok = F;
+      }
+
+      hb_xfree( idxname );
+      svg_index_free( svg->index );
+      svg->index = NULL;
+   }
+
+   svg_text_cache_free( svg );
+
+   if( svg->filename )
+   {
+      hb_xfree( svg->filename );
+      svg->filename = NULL;
+   }
+
+   return ok;
+}
+
+/* ------------------------------------------------------------------------- */
+// API functions
+/* svg_init( <cFileName>, <nWidth>, <nHeight>[, <nFlags>] ) --> <pHandle> | NIL */
+HB_FUNC( SVG_INIT )
+{
+   const char *filename = hb_parc( 1 );
+
+   if( filename )
+   {
+      int flags = hb_parni( 4 );
+      HB_SIZE cache_limit = 0;
+      char *cache = ( flags & SVG_FLAG_CACHE ) ? svg_cache_dir( &cache_limit ) : NULL;
+      FILE *file = NULL;
+
+      // A cached document is written to its file only by svg_close()
+      if( cache == NULL )
+      {
+         svg_cache_detach( filename );
+         file = fopen( filename, "w" );
+         if( file == NULL )
          {
-            svg_line( svg, x, y + tick_length, x, y, 1, color );
+            fprintf( stderr, "Error: Could not open file '%s' for writing.\n", filename );
+            hb_ret(); // Return NIL to indicate failure
+            return;
          }
 
-         // Adjust the label offset based on the number of digits
-         int num_digits = strlen( label );
-         if( x1 == x2 )  // Only adjust for vertical arrows
+         // Output is buffered in svg->out, a stdio buffer would only add a copy
+         setvbuf( file, NULL, _IONBF, 0 );
+      }
+
+      SVG_RECORDER *recorder = NULL;
+
+      if( flags & SVG_FLAG_RECORD )
+      {
+         // The calls are recorded next to the document as <cFileName>.svgb
+         char *binname = ( char * ) hb_xgrab( strlen( filename ) + 6 );
+         strcpy( binname, filename );
+         strcat( binname, ".svgb" );
+
+         // Replay writes the document itself, neither cached nor recorded again
+         recorder = svg_recorder_new( binname, hb_parni( 2 ), hb_parni( 3 ), flags & ~( SVG_FLAG_RECORD | SVG_FLAG_CACHE ) );
+         hb_xfree( binname );
+
+         if( recorder == NULL )
          {
-            label_offset_x = -10 * num_digits;  // Assume each digit is about 10 units wide
+            if( file )
+            {
+               fclose( file );
+            }
+            if( cache )
+            {
+               hb_xfree( cache );
+            }
+            hb_ret(); // Return NIL to indicate failure
+            return;
          }
+      }
+
+      SVG *svg = svg_new();
+
+      svg->file = file;
+      svg->cache = cache;
+      svg->cache_limit = cache_limit;
+      svg->width = hb_parni( 2 );
+      svg->height = hb_parni( 3 );
+      svg->flags = flags;
+      svg->filename = hb_strdup( filename );
+      svg->recorder = recorder;
 
-         // Additional adjustment for values 100 or greater
-         if( num >= 100 )
+      if( file && ( flags & SVG_FLAG_ASYNC ) )
+      {
+         svg->writer = svg_writer_new( file );
+         if( svg->writer )
          {
-            label_offset_x += 3;
+            svg->flush_size = SVG_ASYNC_SIZE;
+            svg_buffer_reserve( &svg->out, SVG_ASYNC_SIZE + 1024 );
          }
+      }
 
-         svg_text( svg, x + label_offset_x, y + label_offset_y, label, "Arial", 12, 400, color );
+      if( flags & SVG_FLAG_CACHE )
+      {
+         // The file name is not part of the key: identical drawings share one entry, as
+         // long as they are written by the same SVG_CACHE_FORMAT
+         svg->hash = svg_hash_u64( svg_hash_u64( svg_hash_u64( SVG_CACHE_FORMAT, ( HB_U64 ) svg->width ), ( HB_U64 ) svg->height ), ( HB_U64 ) flags );
+      }
+
+      if( svg->flags & SVG_FLAG_INDEX )
+      {
+         svg->index = svg_index_new();
       }
+
+      if( !( svg->flags & SVG_FLAG_MINIFY ) )
+      {
+         svg_printf( svg, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n" );
+         svg_printf( svg, "<!DOCTYPE svg PUBLIC \"-//W3C//DTD SVG 1.1//EN\" " );
+         svg_printf( svg, "\"http://www.w3.org/Graphics/SVG/1.1/DTD/svg11.dtd\">\n" );
+      }
+      svg_printf( svg, SVG_FMT( svg, "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%d\" height=\"%d\" viewBox=\"0 0 %d %d\">\n", "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%d\" height=\"%d\" viewBox=\"0 0 %d %d\">" ), svg->width, svg->height, svg->width, svg->height );
+
+      hb_svg_Return( svg );
    }
    else
    {
@@ -481,82 +821,1092 @@ HB_FUNC( SVG_NUMBERED_ARROW )
    }
 }
 
-/* svg_numbered_arrow_xy( <pHandle>, <nX1>, <nY1>, <nX2>, <nY3>, <nStroke_width>, <nStart_num>, <nEnd_num>, <nStep>, nColor> ) --> NIL */
-HB_FUNC( SVG_NUMBERED_ARROW_XY )
+/* svg_init_tiled( <cPrefix>, <nWidth>, <nHeight>, <nTileSize>, <nLevels>[, <nFlags>] ) --> <pHandle> | NIL */
+/* Writes <cPrefix><nLevel>_<nColumn>_<nRow>.svg tiles; level nLevels - 1 is full resolution.
+   Only SVG_FLAG_INDEX and SVG_FLAG_MINIFY apply to tiles, the other flags are an argument error. */
+HB_FUNC( SVG_INIT_TILED )
+{
+   const char *prefix = hb_parc( 1 );
+   int width = hb_parni( 2 );
+   int height = hb_parni( 3 );
+   int tile_size = hb_parni( 4 );
+   int levels = hb_parni( 5 );
+   int flags = hb_parni( 6 );
+
+   if( prefix && width > 0 && height > 0 && tile_size > 0 && levels > 0 && levels <= 24 &&
+       !( flags & ( SVG_FLAG_CACHE | SVG_FLAG_ASYNC | SVG_FLAG_RECORD ) ) )
+   {
+      SVG *svg = svg_new();
+
+      svg->width = width;
+      svg->height = height;
+      svg->flags = flags;
+      svg->filename = hb_strdup( prefix );
+      svg->tiles = svg_tiles_new( prefix, width, height, tile_size, levels, ( svg->flags & SVG_FLAG_MINIFY ) != 0 );
+
+      if( svg->flags & SVG_FLAG_INDEX )
+      {
+         svg->index = svg_index_new();
+      }
+
+      hb_svg_Return( svg );
+   }
+   else
+   {
+      HB_ERR_ARGS();
+   }
+}
+
+/* svg_set_background( <pHandle>, <nHexColor> ) --> NIL */
+HB_FUNC( SVG_SET_BACKGROUND )
 {
    SVG *svg = hb_svg_Param( 1 );
-   int x1 = hb_parni( 2 );
-   int y1 = hb_parni( 3 );
-   int x2 = hb_parni( 4 );
-   int y3 = hb_parni( 5 );
-   int stroke_width = hb_parni( 6 );
-   int start_num = hb_parni( 7 );
-   int end_num = hb_parni( 8 );
-   int step = hb_parni( 9 );
-   unsigned int color = hb_parni( 10 );
 
    if( svg )
    {
-      // Drawing horizontal arrow
-      svg_arrow( svg, x1, y1, x2, y1, stroke_width, color );
-      // Drawing vertical arrow
-      svg_arrow( svg, x1, y1, x1, y3, stroke_width, color );
+      svg_call( svg );
 
-      // Determining the number of labels on the arrow
-      int num_labels = ( end_num - start_num ) / step + 1;
+      unsigned long hexColor = hb_parnl( 2 );
 
-      // Common adjustments for labels
-      int label_offset_x = 0;
-      int label_offset_y = 15;
+      svg_bbox_none( svg );
 
-      // Adding labels and tick marks for the horizontal arrow
-      float dx = ( x2 - x1 ) / ( float ) ( num_labels - 1 );
-      for( int i = 0; i < num_labels; ++i )
+      if( hexColor <= 0xFFFFFF )
       {
-         int x = x1 + dx * i;
-         int y = y1;
-         int num = start_num + step * i;
-         char label[ 10 ];
-         sprintf( label, "%d", num );
-
-         // Draw tick mark for horizontal arrow
-         int tick_length = (i % 5 == 0) ? 10 : 5; // Every fifth tick mark is longer
-         svg_line(svg, x, y + tick_length, x, y, 1, color);
+         // No alpha channel, use full opacity
+         if( svg->flags & SVG_FLAG_MINIFY )
+         {
+            svg_printf( svg, "<rect width=\"%d\" height=\"%d\" fill=\"%s\"/>", svg->width, svg->height, svg_color( svg, hexColor ) );
+         }
+         else
+         {
+            svg_printf( svg, "<rect x=\"0\" y=\"0\" width=\"%d\" height=\"%d\" fill=\"#%06lX\" fill-opacity=\"1\"/>\n", svg->width, svg->height, hexColor );
+         }
+      }
+      else if( hexColor <= 0xFFFFFFFF )
+      {
+         // Alpha channel is available
+         double a = ( hexColor & 0xFF ) / 255.0;
+         unsigned int color = ( hexColor >> 8 ) & 0xFFFFFF;
+         if( svg->flags & SVG_FLAG_MINIFY )
+         {
+            svg_printf( svg, "<rect width=\"%d\" height=\"%d\" fill=\"%s\" fill-opacity=\"%.3g\"/>", svg->width, svg->height, svg_color( svg, color ), a );
+         }
+         else
+         {
+            svg_printf( svg, "<rect x=\"0\" y=\"0\" width=\"%d\" height=\"%d\" fill=\"#%06X\" fill-opacity=\"%f\"/>\n", svg->width, svg->height, color, a );
+         }
+      }
+      else
+      {
+         fprintf( stderr, "Invalid hex value passed\n" );
+      }
+   }
+   else
+   {
+      HB_ERR_ARGS();
+   }
+}
+
+/* svg_close( <pHandle> ) --> <lOK>, or the document key ( "" on failure ) when SVG_FLAG_CACHE found a cache directory */
+HB_FUNC( SVG_CLOSE )
+{
+   SVG **ppSVG = ( SVG ** ) hb_parptrGC( &s_gcSVGFuncs, 1 );
+
+   if( ppSVG && *ppSVG )
+   {
+      SVG *svg = *ppSVG;
+
+      // The handle is no longer valid, neither for API calls nor for the garbage collector
+      *ppSVG = NULL;
+
+      // svg_finish() releases svg->cache; without a cache directory the file is written directly
+      bool cached = svg->cache != NULL;
+      bool ok = svg_finish( svg );
+
+      if( cached )
+      {
+         char key[ 17 ];
+
+         svg_cache_key( svg->hash, key );
+         hb_retc( ok ? key : "" );
+      }
+      else
+      {
+         hb_retl( ok );
+      }
+      svg_free( svg );
+   }
+   else
+   {
+      fprintf( stderr, "Error: svg_close called with NULL SVG pointer.\n" );
+      HB_ERR_ARGS();
+   }
+}
+
+/* svg_rect( <pHandle>, <nX>, <nY>, <nWidth>, <nHeight>, <nStroke_width>, <nColor> ) --> NIL */
+HB_FUNC( SVG_RECT )
+{
+   SVG *svg = hb_svg_Param( 1 );
+
+   if( svg )
+   {
+      svg_call( svg );
+
+      int x = hb_parni( 2 );
+      int y = hb_parni( 3 );
+      int width = hb_parni( 4 );
+      int height = hb_parni( 5 );
+      int stroke_width = hb_parni( 6 );
+      unsigned int color = hb_parni( 7 );
+
+      svg_bbox( svg, x - stroke_width / 2, y - stroke_width / 2, x + width + stroke_width / 2, y + height + stroke_width / 2 );
+      svg_printf( svg, SVG_FMT( svg, "<rect x=\"%d\" y=\"%d\" width=\"%d\" height=\"%d\"%s stroke=\"%s\" fill=\"none\"/>\n", "<rect x=\"%d\" y=\"%d\" width=\"%d\" height=\"%d\"%s stroke=\"%s\" fill=\"none\"/>" ), x, y, width, height, svg_attr( svg, "stroke-width", stroke_width, 1 ), svg_color( svg, color ) );
+   }
+   else
+   {
+      HB_ERR_ARGS();
+   }
+}
+
+/* svg_filled_rect( <pHandle>, <nX>, <nY>, <nWidth>, <nHeight>, <nColor> ) --> NIL */
+HB_FUNC( SVG_FILLED_RECT )
+{
+   SVG *svg = hb_svg_Param( 1 );
+
+   if( svg )
+   {
+      svg_call( svg );
+
+      int x = hb_parni( 2 );
+      int y = hb_parni( 3 );
+      int width = hb_parni( 4 );
+      int height = hb_parni( 5 );
+      unsigned int color = hb_parni( 6 );
+
+      svg_bbox( svg, x, y, x + width, y + height );
+      svg_printf( svg, SVG_FMT( svg, "<rect x=\"%d\" y=\"%d\" width=\"%d\" height=\"%d\" fill=\"%s\"/>\n", "<rect x=\"%d\" y=\"%d\" width=\"%d\" height=\"%d\" fill=\"%s\"/>" ), x, y, width, height, svg_color( svg, color ) );
+   }
+   else
+   {
+      HB_ERR_ARGS();
+   }
+}
+
+/* svg_triangle( <pHandle>, <nX1>, <nY1>, <nX2>, <nY2>, <nX3>, <nY3>, <nStroke_width>, <nColor> ) --> NIL */
+HB_FUNC( SVG_TRIANGLE )
+{
+   SVG *svg = hb_svg_Param( 1 );
+
+   if( svg )
+   {
+      svg_call( svg );
+
+      int x1 = hb_parni( 2 );
+      int y1 = hb_parni( 3 );
+      int x2 = hb_parni( 4 );
+      int y2 = hb_parni( 5 );
+      int x3 = hb_parni( 6 );
+      int y3 = hb_parni( 7 );
+      int stroke_width = hb_parni( 8 );
+      unsigned int color = hb_parni( 9 );
+
+      int points[ 6 ] = { x1, y1, x2, y2, x3, y3 };
+
+      svg_bbox_points( svg, points, 6, stroke_width );
+      svg_printf( svg, SVG_FMT( svg, "<polygon points=\"%d,%d %d,%d %d,%d\"%s stroke=\"%s\" fill=\"none\"/>\n", "<polygon points=\"%d,%d %d,%d %d,%d\"%s stroke=\"%s\" fill=\"none\"/>" ), x1, y1, x2, y2, x3, y3, svg_attr( svg, "stroke-width", stroke_width, 1 ), svg_color( svg, color ) );
+   }
+   else
+   {
+      HB_ERR_ARGS();
+   }
+}
+/* svg_filled_triangle( <pHandle>, <nX1>, <nY1>, <nX2>, <nY2>, <nX3>, <nY3>, <nColor> ) --> NIL */
+HB_FUNC( SVG_FILLED_TRIANGLE )
+{
+   SVG *svg = hb_svg_Param( 1 );
+
+   if( svg )
+   {
+      svg_call( svg );
+
+      int x1 = hb_parni( 2 );
+      int y1 = hb_parni( 3 );
+      int x2 = hb_parni( 4 );
+      int y2 = hb_parni( 5 );
+      int x3 = hb_parni( 6 );
+      int y3 = hb_parni( 7 );
+      unsigned int color = hb_parni( 8 );
+      int points[ 6 ] = { x1, y1, x2, y2, x3, y3 };
+
+      svg_bbox_points( svg, points, 6, 0 );
+      svg_printf( svg, SVG_FMT( svg, "<polygon points=\"%d,%d %d,%d %d,%d\" fill=\"%s\"/>\n", "<polygon points=\"%d,%d %d,%d %d,%d\" fill=\"%s\"/>" ), x1, y1, x2, y2, x3, y3, svg_color( svg, color ) );
+   }
+   else
+   {
+      HB_ERR_ARGS();
+   }
+}
+
+/* svg_circle( <pHandle>, <nCx>, <nCy>, <nR>, <nStroke_width>, <nColor> ) --> NIL */
+HB_FUNC( SVG_CIRCLE )
+{
+   SVG *svg = hb_svg_Param( 1 );
+
+   if( svg )
+   {
+      svg_call( svg );
+
+      int cx = hb_parni( 2 );
+      int cy = hb_parni( 3 );
+      int r = hb_parni( 4 );
+      int stroke_width = hb_parni( 5 );
+      unsigned int color = hb_parni( 6 );
+
+      svg_bbox( svg, cx - r - stroke_width / 2, cy - r - stroke_width / 2, cx + r + stroke_width / 2, cy + r + stroke_width / 2 );
+      svg_printf( svg, SVG_FMT( svg, "<circle cx=\"%d\" cy=\"%d\" r=\"%d\"%s stroke=\"%s\" fill=\"none\"/>\n", "<circle cx=\"%d\" cy=\"%d\" r=\"%d\"%s stroke=\"%s\" fill=\"none\"/>" ), cx, cy, r, svg_attr( svg, "stroke-width", stroke_width, 1 ), svg_color( svg, color ) );
+   }
+   else
+   {
+      HB_ERR_ARGS();
+   }
+}
+
+/* svg_filled_circle( <pHandle>, <nCx>, <nCy>, <nR>, <nColor> ) --> NIL */
+HB_FUNC( SVG_FILLED_CIRCLE )
+{
+   SVG *svg = hb_svg_Param( 1 );
+
+   if( svg )
+   {
+      svg_call( svg );
+
+      int cx = hb_parni( 2 );
+      int cy = hb_parni( 3 );
+      int r = hb_parni( 4 );
+      unsigned int color = hb_parni( 5 );
+
+      svg_bbox( svg, cx - r, cy - r, cx + r, cy + r );
+      svg_printf( svg, SVG_FMT( svg, "<circle cx=\"%d\" cy=\"%d\" r=\"%d\" fill=\"%s\"/>\n", "<circle cx=\"%d\" cy=\"%d\" r=\"%d\" fill=\"%s\"/>" ), cx, cy, r, svg_color( svg, color ) );
+   }
+   else
+   {
+      HB_ERR_ARGS();
+   }
+}
+
+/* svg_line( <pHandle>, <nX1>, <nY1>, <nX2>, <nY2>, <nStroke_width>, <nColor> ) --> NIL */
+HB_FUNC( SVG_LINE )
+{
+   SVG *svg = hb_svg_Param( 1 );
+
+   if( svg )
+   {
+      svg_call( svg );
+
+      int x1 = hb_parni( 2 );
+      int y1 = hb_parni( 3 );
+      int x2 = hb_parni( 4 );
+      int y2 = hb_parni( 5 );
+      int stroke_width = hb_parni( 6 );
+      unsigned int color = hb_parni( 7 );
+      int points[ 4 ] = { x1, y1, x2, y2 };
+
+      svg_bbox_points( svg, points, 4, stroke_width );
+      svg_line( svg, x1, y1, x2, y2, stroke_width, color );
+   }
+   else
+   {
+      HB_ERR_ARGS();
+   }
+}
+
+/* svg_polyline( <pHandle>, <aPoints>, <nPint_count>, <nStroke_width>, <nColor> ) --> NIL */
+HB_FUNC( SVG_POLYLINE )
+{
+   SVG *svg = hb_svg_Param( 1 );
+   PHB_ITEM pItem;
+
+   if( svg && ( pItem = hb_param( 2, HB_IT_ARRAY ) ) != NULL )
+   {
+      svg_call( svg );
+
+      int point_count = hb_parni( 3 );
+      int stroke_width = hb_parni( 4 );
+      unsigned int color = hb_parni( 5 );
+
+      point_count = ( int ) hb_arrayLen( pItem );
+      int *points = NULL;
+
+      if( point_count )
+      {
+         points = ( int * ) hb_xgrab( point_count * sizeof( int ) );
+      }
+
+      // Retrieving elements from the Harbour array into the points array
+      for( int i = 0; i < point_count; ++i )
+      {
+         points[ i ] = hb_arrayGetNI( pItem, ( HB_SIZE ) i + 1 );
+      }
+
+      svg_bbox_points( svg, points, point_count, stroke_width );
+      svg_printf( svg, "<polyline points=\"" );
+
+      for( int i = 0; i < point_count; i += 2 )
+      {
+         svg_printf( svg, i ? " %d,%d" : "%d,%d", points[ i ], points[ i + 1 ] );
+      }
+
+      svg_printf( svg, SVG_FMT( svg, "\"%s stroke=\"%s\" fill=\"none\"/>\n", "\"%s stroke=\"%s\" fill=\"none\"/>" ), svg_attr( svg, "stroke-width", stroke_width, 1 ), svg_color( svg, color ) );
+
+      if( points )
+      {
+         hb_xfree( points );
+      }
+   }
+   else
+   {
+      HB_ERR_ARGS();
+   }
+}
+/* svg_arrow( <pHandle>, <nX1>, <nY1>, <nX2>, <nY2>, <nStroke_width>, <nColor> ) --> NIL */
+HB_FUNC( SVG_ARROW )
+{
+   SVG *svg = hb_svg_Param( 1 );
+   int x1 = hb_parni( 2 );
+   int y1 = hb_parni( 3 );
+   int x2 = hb_parni( 4 );
+   int y2 = hb_parni( 5 );
+   int stroke_width = hb_parni( 6 );
+   unsigned int color = hb_parni( 7 );
+
+   if( svg )
+   {
+      svg_call( svg );
+
+      // The arrow head reaches at most 10 units beyond the shaft
+      int points[ 4 ] = { x1, y1, x2, y2 };
+
+      svg_bbox_points( svg, points, 4, stroke_width + 20 );
+      svg_arrow( svg, x1, y1, x2, y2, stroke_width, color );
+   }
+   else
+   {
+      HB_ERR_ARGS();
+   }
+}
+
+/* svg_numbered_arrow( <pHandle>, <nX1>, <nY1>, <nX2>, <nY2>, <nStroke_width>, <nStart_num>, <nEnd_num>, <nStep>, <nColor> ) --> NIL */
+HB_FUNC( SVG_NUMBERED_ARROW )
+{
+   SVG *svg = hb_svg_Param( 1 );
+   int x1 = hb_parni( 2 );
+   int y1 = hb_parni( 3 );
+   int x2 = hb_parni( 4 );
+   int y2 = hb_parni( 5 );
+   int stroke_width = hb_parni( 6 );
+   int start_num = hb_parni( 7 );
+   int end_num = hb_parni( 8 );
+   int step = hb_parni( 9 );
+   unsigned int color = hb_parni( 10 );
+
+   if( svg )
+   {
+      svg_call( svg );
+
+      // Arrow head, tick marks and labels stay within about 60 units of the shaft
+      int points[ 4 ] = { x1, y1, x2, y2 };
+
+      svg_bbox_points( svg, points, 4, 120 );
+
+      // Drawing an arrow
+      svg_arrow( svg, x1, y1, x2, y2, stroke_width, color );
+
+      // Determining the number of labels on the arrow
+      int num_labels = ( end_num - start_num ) / step + 1;
+
+      // Determining the spacing between labels on the arrow
+      float dx = ( x2 - x1 ) / ( float ) ( num_labels - 1 );
+      float dy = ( y2 - y1 ) / ( float ) ( num_labels - 1 );
+
+      // Labels end left of a vertical arrow, otherwise they are centred below the tick marks
+      int label_gap = 7;
+      int label_offset_y = 15;
+
+      // Adding labels and tick marks
+      for( int i = 0; i < num_labels; ++i )
+      {
+         int x = x1 + dx * i;
+         int y = y1 + dy * i;
+         int num = start_num + step * i;
+         char label[ 10 ];
+         sprintf( label, "%d", num );
+
+         // Draw tick mark
+         int tick_length = ( i % 5 == 0 ) ? 10 : 5; // Every fifth tick mark is longer
+         if( x1 == x2 )
+         {
+            svg_line( svg, x - tick_length, y, x, y, 1, color );
+         }
+         else
+         {
+            svg_line( svg, x, y + tick_length, x, y, 1, color );
+         }
+
+         if( x1 == x2 )
+         {
+            svg_label( svg, x - label_gap, y, label, SVG_ALIGN_RIGHT, color );
+         }
+         else
+         {
+            svg_label( svg, x, y + label_offset_y, label, SVG_ALIGN_CENTER, color );
+         }
+      }
+   }
+   else
+   {
+      HB_ERR_ARGS();
+   }
+}
+
+/* svg_numbered_arrow_xy( <pHandle>, <nX1>, <nY1>, <nX2>, <nY3>, <nStroke_width>, <nStart_num>, <nEnd_num>, <nStep>, nColor> ) --> NIL */
+HB_FUNC( SVG_NUMBERED_ARROW_XY )
+{
+   SVG *svg = hb_svg_Param( 1 );
+   int x1 = hb_parni( 2 );
+   int y1 = hb_parni( 3 );
+   int x2 = hb_parni( 4 );
+   int y3 = hb_parni( 5 );
+   int stroke_width = hb_parni( 6 );
+   int start_num = hb_parni( 7 );
+   int end_num = hb_parni( 8 );
+   int step = hb_parni( 9 );
+   unsigned int color = hb_parni( 10 );
+
+   if( svg )
+   {
+      svg_call( svg );
+
+      // Arrow heads, tick marks and labels stay within about 60 units of the axes
+      int points[ 6 ] = { x2, y1, x1, y1, x1, y3 };
+
+      svg_bbox_points( svg, points, 6, 120 );
+
+      // Drawing horizontal arrow
+      svg_arrow( svg, x1, y1, x2, y1, stroke_width, color );
+      // Drawing vertical arrow
+      svg_arrow( svg, x1, y1, x1, y3, stroke_width, color );
+
+      // Determining the number of labels on the arrow
+      int num_labels = ( end_num - start_num ) / step + 1;
+
+      // Adding labels and tick marks for the horizontal and the vertical arrow
+      svg_ticks_x( svg, x1, y1, x2, start_num, step, num_labels, color );
+      svg_ticks_y( svg, x1, y1, y3, start_num, step, num_labels, T, color );
+   }
+   else
+   {
+      HB_ERR_ARGS();
+   }
+}
+
+/* svg_hexagon( <pHandle>, <nHx>, <nHy>, <nR>, <nStroke_width>, <lType>, <nColor> ) --> NIL */
+HB_FUNC( SVG_HEXAGON )
+{
+   SVG *svg = hb_svg_Param( 1 );
+
+   if( svg )
+   {
+      svg_call( svg );
+
+      int hx = hb_parni( 2 );
+      int hy = hb_parni( 3 );
+      int r = hb_parni( 4 );
+      int stroke_width = hb_parni( 5 );
+      bool type = hb_parl( 6 );
+      unsigned int color = hb_parni( 7 );
+
+      svg_bbox( svg, hx - r, hy - r, hx + r, hy + r );
+
+      double a = 2 * M_PI / 6;
+      double angle_offset = ( type == 0 ? M_PI_2 : M_PI / 3 ); // Decides the orientation
+      double x1 = hx + r * cos( a * 5 + angle_offset );
+      double y1 = hy + r * sin( a * 5 + angle_offset );
+
+      svg_printf( svg, "<polygon points=\"%.2lf,%.2lf", x1, y1 );
+
+      for( int i = 0; i < 6; ++i )
+      {
+         double x = hx + r * cos( a * i + angle_offset );
+         double y = hy + r * sin( a * i + angle_offset );
+         svg_printf( svg, " %.2lf,%.2lf", x, y );
+      }
+
+      svg_printf( svg, "\"%s stroke=\"%s\"", svg_attr( svg, "stroke-width", stroke_width, 1 ), svg_color( svg, color ) );
+      svg_printf( svg, SVG_FMT( svg, " fill=\"none\"/>\n", " fill=\"none\"/>" ) );
+   }
+   else
+   {
+      HB_ERR_ARGS();
+   }
+}
+
+/* svg_filled_hexagon( <pHandle>, <nHx>, <nHy>, <nR>, <lType>, <nColor> ) --> NIL */
+HB_FUNC( SVG_FILLED_HEXAGON )
+{
+   SVG *svg = hb_svg_Param( 1 );
+
+   if( svg )
+   {
+      svg_call( svg );
+
+      int hx = hb_parni( 2 );
+      int hy = hb_parni( 3 );
+      int r = hb_parni( 4 );
+      bool type = hb_parl( 5 );
+      unsigned int color = hb_parni( 6 );
+
+      svg_bbox( svg, hx - r, hy - r, hx + r, hy + r );
+
+      double a = 2 * M_PI / 6;
+      double angle_offset = ( type == 0 ? M_PI_2 : M_PI / 3 ); // Decides the orientation
+      double x1 = hx + r * cos( a * 5 + angle_offset );
+      double y1 = hy + r * sin( a * 5 + angle_offset );
+
+      svg_printf( svg, "<polygon points=\"%.2lf,%.2lf", x1, y1 );
+
+      for( int i = 0; i < 6; ++i )
+      {
+         double x = hx + r * cos( a * i + angle_offset );
+         double y = hy + r * sin( a * i + angle_offset );
+         svg_printf( svg, " %.2lf,%.2lf", x, y );
+      }
+
+      svg_printf( svg, "\" stroke=\"%s\"%s", svg_color( svg, color ), svg_attr( svg, "stroke-width", 1, 1 ) );
+      svg_printf( svg, SVG_FMT( svg, " fill=\"%s\"/>\n", " fill=\"%s\"/>" ), svg_color( svg, color ) );
+   }
+   else
+   {
+      HB_ERR_ARGS();
+   }
+}
+
+/* svg_ellipse( <pHandle>, <nCx>, <nCy>, <nRx>, <nRy>, <nStroke_width>, <nColor> ) --> NIL */
+HB_FUNC( SVG_ELLIPSE )
+{
+   SVG *svg = hb_svg_Param( 1 );
+
+   if( svg )
+   {
+      svg_call( svg );
+
+      int cx = hb_parni( 2 );
+      int cy = hb_parni( 3 );
+      int rx = hb_parni( 4 );
+      int ry = hb_parni( 5 );
+      int stroke_width = hb_parni( 6 );
+      unsigned int color = hb_parni( 7 );
+
+      svg_bbox( svg, cx - rx - stroke_width / 2, cy - ry - stroke_width / 2, cx + rx + stroke_width / 2, cy + ry + stroke_width / 2 );
+      svg_printf( svg, SVG_FMT( svg, "<ellipse cx=\"%d\" cy=\"%d\" rx=\"%d\" ry=\"%d\" stroke=\"%s\"%s fill=\"none\"/>\n", "<ellipse cx=\"%d\" cy=\"%d\" rx=\"%d\" ry=\"%d\" stroke=\"%s\"%s fill=\"none\"/>" ), cx, cy, rx, ry, svg_color( svg, color ), svg_attr( svg, "stroke-width", stroke_width, 1 ) );
+   }
+   else
+   {
+      HB_ERR_ARGS();
+   }
+}
+
+/* svg_filled_ellipse( <pHandle>, <nCx>, <nCy>, <nRx>, <nRy>, <nColor> ) --> NIL */
+HB_FUNC( SVG_FILLED_ELLIPSE )
+{
+   SVG *svg = hb_svg_Param( 1 );
+
+   if( svg )
+   {
+      svg_call( svg );
+
+      int cx = hb_parni( 2 );
+      int cy = hb_parni( 3 );
+      int rx = hb_parni( 4 );
+      int ry = hb_parni( 5 );
+      unsigned int color = hb_parni( 6 );
+
+      svg_bbox( svg, cx - rx, cy - ry, cx + rx, cy + ry );
+      svg_printf( svg, SVG_FMT( svg, "<ellipse cx=\"%d\" cy=\"%d\" rx=\"%d\" ry=\"%d\" fill=\"%s\"/>\n", "<ellipse cx=\"%d\" cy=\"%d\" rx=\"%d\" ry=\"%d\" fill=\"%s\"/>" ), cx, cy, rx, ry, svg_color( svg, color ) );
+   }
+   else
+   {
+      HB_ERR_ARGS();
+   }
+}
+/* svg_bezier_curve( <pHandle>, <aPoints>, <nPoint_count>, <nStroke_width>, <nColor> ) --> NIL */
+HB_FUNC( SVG_BEZIER_CURVE )
+{
+   SVG *svg = hb_svg_Param( 1 );
+   PHB_ITEM pItem;
+
+   if( svg && ( pItem = hb_param( 2, HB_IT_ARRAY ) ) != NULL )
+   {
+      svg_call( svg );
+
+      int point_count = hb_parni( 3 );
+      int stroke_width = hb_parni( 4 );
+      unsigned int color = hb_parni( 5 );
+
+      point_count = ( int ) hb_arrayLen( pItem );
+      int *points = NULL;
+
+      if( point_count )
+      {
+         points = ( int * ) hb_xgrab( point_count * sizeof( int ) );
+      }
+
+      // Retrieving elements from the Harbour array into the points array
+      for( int i = 0; i < point_count; ++i )
+      {
+         points[ i ] = hb_arrayGetNI( pItem, ( HB_SIZE ) i + 1 );
+      }
+
+      // A cubic Bezier never leaves the hull of its control points
+      svg_bbox_points( svg, points, point_count, stroke_width );
+      svg_printf( svg, "<path d=\"M %d %d", points[ 0 ], points[ 1 ] );
+
+      for( int i = 2; i < point_count; i += 6 )
+      {
+         svg_printf( svg, SVG_FMT( svg, " C %d %d, %d %d, %d %d", " C %d %d,%d %d,%d %d" ), points[ i ], points[ i + 1 ], points[ i + 2 ], points[ i + 3 ], points[ i + 4 ], points[ i + 5 ] );
+      }
+
+      svg_printf( svg, SVG_FMT( svg, "\" stroke=\"%s\"%s fill=\"none\"/>\n", "\" stroke=\"%s\"%s fill=\"none\"/>" ), svg_color( svg, color ), svg_attr( svg, "stroke-width", stroke_width, 1 ) );
+
+      if( points )
+      {
+         hb_xfree( points );
+      }
+   }
+   else
+   {
+      HB_ERR_ARGS();
+   }
+}
+
+// void svg_text( SVG *svg, int x, int y, const char *text, const char *font, int size, int font_weight, unsigned int color );
+HB_FUNC( SVG_TEXT )
+{
+   SVG *svg = hb_svg_Param( 1 );
+
+   if( svg )
+   {
+      svg_call( svg );
+
+      int x = hb_parni( 2 );
+      int y = hb_parni( 3 );
+      const char *text = hb_parc( 4 );
+      const char *font = hb_parc( 5 );
+      int size = hb_parni( 6 );
+      int font_weight = hb_parni( 7 );
+      unsigned int color = hb_parni( 8 );
+
+      // Measured advance, only needed for the index or tiles; descenders reach about 0.25 em below the baseline
+      int width = ( svg->index || svg->tiles ) ? ( int ) ceil( svg_text_measure( svg, text, font, size, font_weight ) ) : 0;
+
+      svg_bbox( svg, x, y - size, x + width, y + size / 4 );
+      svg_text( svg, x, y, text, font, size, font_weight, color );
+   }
+   else
+   {
+      HB_ERR_ARGS();
+   }
+}
+
+/* svg_text_aligned( <pHandle>, <nX>, <nY>, <cText>, <cFont>, <nSize>, <nFont_weight>, <nColor>, <nAlign> ) --> NIL */
+/* nAlign SVG_ALIGN_LEFT, SVG_ALIGN_CENTER or SVG_ALIGN_RIGHT: nX is the left end, the middle or the right end of the text */
+HB_FUNC( SVG_TEXT_ALIGNED )
+{
+   SVG *svg = hb_svg_Param( 1 );
+
+   if( svg )
+   {
+      svg_call( svg );
+
+      int y = hb_parni( 3 );
+      const char *text = hb_parc( 4 );
+      const char *font = hb_parc( 5 );
+      int size = hb_parni( 6 );
+      int font_weight = hb_parni( 7 );
+      unsigned int color = hb_parni( 8 );
+      double width = svg_text_measure( svg, text, font, size, font_weight );
+      int x = svg_align_x( hb_parni( 2 ), width, hb_parni( 9 ) );
+
+      svg_bbox( svg, x, y - size, x + ( int ) ceil( width ), y + size / 4 );
+      svg_text( svg, x, y, text, font, size, font_weight, color );
+   }
+   else
+   {
+      HB_ERR_ARGS();
+   }
+}
+
+/* svg_text_width( <cText>, <cFont>, <nSize>[, <nFont_weight>] ) --> <nWidth> */
+HB_FUNC( SVG_TEXT_WIDTH )
+{
+   const char *text = hb_parc( 1 );
+
+   if( text )
+   {
+      hb_retnd( svg_text_measure( NULL, text, hb_parc( 2 ), hb_parni( 3 ), hb_parnidef( 4, 400 ) ) );
+   }
+   else
+   {
+      HB_ERR_ARGS();
+   }
+}
+
+/* Linear gradient */
+/* svg_linear_gradient( <pHandle>, <cId>, <nStartColor>, <nEndColor>, <nX1>, <nY1>, <nX2>, <nY2> ) --> NIL */
+HB_FUNC( SVG_LINEAR_GRADIENT )
+{
+   SVG *svg = hb_svg_Param( 1 );
+
+   if( svg )
+   {
+      svg_call( svg );
+
+      const char *id = hb_parc( 2 );
+      unsigned int startColor = hb_parni( 3 );
+      unsigned int endColor = hb_parni( 4 );
+      float x1 = hb_parnd( 5 );
+      float y1 = hb_parnd( 6 );
+      float x2 = hb_parnd( 7 );
+      float y2 = hb_parnd( 8 );
+
+      svg_bbox_none( svg );
+      if( svg->flags & SVG_FLAG_MINIFY )
+      {
+         svg_printf( svg, "<defs><linearGradient id=\"%s\" x1=\"%g%%\" y1=\"%g%%\" x2=\"%g%%\" y2=\"%g%%\"><stop offset=\"0%%\" style=\"stop-color:%s\"/><stop offset=\"100%%\" style=\"stop-color:%s\"/></linearGradient></defs>",
+                     id, x1, y1, x2, y2, svg_color( svg, startColor ), svg_color( svg, endColor ) );
+      }
+      else
+      {
+         svg_printf( svg, "<defs>\n" );
+         svg_printf( svg, "<linearGradient id=\"%s\" x1=\"%f%%\" y1=\"%f%%\" x2=\"%f%%\" y2=\"%f%%\">\n", id, x1, y1, x2, y2 );
+         svg_printf( svg, "<stop offset=\"0%%\" style=\"stop-color:%s;stop-opacity:1\" />\n", svg_color( svg, startColor ) );
+         svg_printf( svg, "<stop offset=\"100%%\" style=\"stop-color:%s;stop-opacity:1\" />\n", svg_color( svg, endColor ) );
+         svg_printf( svg, "</linearGradient>\n" );
+         svg_printf( svg, "</defs>\n" );
+      }
+   }
+   else
+   {
+      HB_ERR_ARGS();
+   }
+}
+
+/* svg_triangle_linear_gradient( <pHandle>, <nX1>, <nY1>, <nX2>, <nY2>, <nX3>, <nY3>, <nStartColor>, <nEndColor> ) --> NIL */ // to be fixed
+HB_FUNC( SVG_TRIANGLE_LINEAR_GRADIENT )
+{
+   SVG *svg = hb_svg_Param( 1 );
+
+   if( svg )
+   {
+      svg_call( svg );
+
+      int x1 = hb_parni( 2 );
+      int y1 = hb_parni( 3 );
+      int x2 = hb_parni( 4 );
+      int y2 = hb_parni( 5 );
+      int x3 = hb_parni( 6 );
+      int y3 = hb_parni( 7 );
+      unsigned int startColor = hb_parni( 8 );
+      unsigned int endColor = hb_parni( 9 );
+
+      // Definition of a linear gradient triangle
+      int gradient_id = svg->linear_gradients++;
+      svg_bbox_none( svg );
+      if( svg->flags & SVG_FLAG_MINIFY )
+      {
+         svg_printf( svg, "<defs><linearGradient id=\"triangleGradient%d\" x1=\"0%%\" y1=\"0%%\" x2=\"100%%\" y2=\"0%%\"><stop offset=\"0%%\" style=\"stop-color:%s\"/><stop offset=\"100%%\" style=\"stop-color:%s\"/></linearGradient></defs>",
+                     gradient_id, svg_color( svg, startColor ), svg_color( svg, endColor ) );
+      }
+      else
+      {
+         svg_printf( svg, "<defs>\n" );
+         svg_printf( svg, "  <linearGradient id=\"triangleGradient%d\" x1=\"0%%\" y1=\"0%%\" x2=\"100%%\" y2=\"0%%\">\n", gradient_id );
+         svg_printf( svg, "    <stop offset=\"0%%\" style=\"stop-color:%s;stop-opacity:1\" />\n", svg_color( svg, startColor ) );
+         svg_printf( svg, "    <stop offset=\"100%%\" style=\"stop-color:%s;stop-opacity:1\" />\n", svg_color( svg, endColor ) );
+         svg_printf( svg, "  </linearGradient>\n" );
+         svg_printf( svg, "</defs>\n" );
+      }
+
+      // Drawing a triangle with a gradient
+      int points[ 6 ] = { x1, y1, x2, y2, x3, y3 };
+
+      svg_bbox_points( svg, points, 6, 0 );
+      svg_printf( svg, SVG_FMT( svg, "<polygon points=\"%d,%d %d,%d %d,%d\" fill=\"url(#triangleGradient%d)\"/>\n", "<polygon points=\"%d,%d %d,%d %d,%d\" fill=\"url(#triangleGradient%d)\"/>" ), x1, y1, x2, y2, x3, y3, gradient_id );
+   }
+   else
+   {
+      HB_ERR_ARGS();
+   }
+}
+
+/* Radial gradient */
+/* svg_radial_gradient( <pHandle>, cId, nInnerColor, nOuterColor, nCx, nCy, nR ) --> NIL */
+HB_FUNC( SVG_RADIAL_GRADIENT )
+{
+   SVG *svg = hb_svg_Param( 1 );
+
+   if( svg )
+   {
+      svg_call( svg );
+
+      const char *id = hb_parc( 2 );
+      unsigned int innerColor = hb_parni( 3 );
+      unsigned int outerColor = hb_parni( 4 );
+      float cx = hb_parnd( 5 );
+      float cy = hb_parnd( 6 );
+      float r = hb_parnd( 7 );
+
+      svg_bbox_none( svg );
+      if( svg->flags & SVG_FLAG_MINIFY )
+      {
+         svg_printf( svg, "<defs><radialGradient id=\"%s\" cx=\"%g%%\" cy=\"%g%%\" r=\"%g%%\"><stop offset=\"0%%\" style=\"stop-color:%s\"/><stop offset=\"100%%\" style=\"stop-color:%s\"/></radialGradient></defs>",
+                     id, cx, cy, r, svg_color( svg, innerColor ), svg_color( svg, outerColor ) );
+      }
+      else
+      {
+         svg_printf( svg, "<defs>\n" );
+         svg_printf( svg, "<radialGradient id=\"%s\" cx=\"%f%%\" cy=\"%f%%\" r=\"%f%%\">\n", id, cx, cy, r );
+         svg_printf( svg, "<stop offset=\"0%%\" style=\"stop-color:%s;stop-opacity:1\"/>\n", svg_color( svg, innerColor ) );
+         svg_printf( svg, "<stop offset=\"100%%\" style=\"stop-color:%s;stop-opacity:1\"/>\n", svg_color( svg, outerColor ) );
+         svg_printf( svg, "</radialGradient>\n" );
+         svg_printf( svg, "</defs>\n" );
+      }
+   }
+   else
+   {
+      HB_ERR_ARGS();
+   }
+}
+
+/* svg_triangle_radial_gradient( <pHandle>, <nX1>, <nY1>, <nX2>, <nY2>, <nX3>, <nY3>, <nStartColor>, <nEndColor> ) --> NIL */ // to be fixed
+HB_FUNC( SVG_TRIANGLE_RADIAL_GRADIENT )
+{
+   SVG *svg = hb_svg_Param( 1 );
+
+   if( svg )
+   {
+      svg_call( svg );
+
+      int x1 = hb_parni( 2 );
+      int y1 = hb_parni( 3 );
+      int x2 = hb_parni( 4 );
+      int y2 = hb_parni( 5 );
+      int x3 = hb_parni( 6 );
+      int y3 = hb_parni( 7 );
+      unsigned int startColor = hb_parni( 8 );
+      unsigned int endColor = hb_parni( 9 );
+
+      // Definition of a radial gradient triangle
+      int gradient_id = svg->radial_gradients++;
+      svg_bbox_none( svg );
+      if( svg->flags & SVG_FLAG_MINIFY )
+      {
+         svg_printf( svg, "<defs><radialGradient id=\"triangleRadialGradient%d\" cx=\"50%%\" cy=\"50%%\" r=\"50%%\"><stop offset=\"0%%\" style=\"stop-color:%s\"/><stop offset=\"100%%\" style=\"stop-color:%s\"/></radialGradient></defs>",
+                     gradient_id, svg_color( svg, startColor ), svg_color( svg, endColor ) );
+      }
+      else
+      {
+         svg_printf( svg, "<defs>\n" );
+         svg_printf( svg, "  <radialGradient id=\"triangleRadialGradient%d\" cx=\"50%%\" cy=\"50%%\" r=\"50%%\">\n", gradient_id );
+         svg_printf( svg, "    <stop offset=\"0%%\" style=\"stop-color:%s;stop-opacity:1\" />\n", svg_color( svg, startColor ) );
+         svg_printf( svg, "    <stop offset=\"100%%\" style=\"stop-color:%s;stop-opacity:1\" />\n", svg_color( svg, endColor ) );
+         svg_printf( svg, "  </radialGradient>\n" );
+         svg_printf( svg, "</defs>\n" );
+      }
+
+      // Drawing a triangle with a gradient
+      int points[ 6 ] = { x1, y1, x2, y2, x3, y3 };
+
+      svg_bbox_points( svg, points, 6, 0 );
+      svg_printf( svg, SVG_FMT( svg, "<polygon points=\"%d,%d %d,%d %d,%d\" fill=\"url(#triangleRadialGradient%d)\"/>\n", "<polygon points=\"%d,%d %d,%d %d,%d\" fill=\"url(#triangleRadialGradient%d)\"/>" ), x1, y1, x2, y2, x3, y3, gradient_id );
+   }
+   else
+   {
+      HB_ERR_ARGS();
+   }
+}
+
+/* svg_rect_gradient( <pHandle>, nX, nY, nWidth, nHeight, cGradient_id ) */
+HB_FUNC( SVG_RECT_GRADIENT )
+{
+   SVG *svg = hb_svg_Param( 1 );
+
+   if( svg )
+   {
+      svg_call( svg );
+
+      int x = hb_parni( 2 );
+      int y = hb_parni( 3 );
+      int width = hb_parni( 4 );
+      int height = hb_parni( 5 );
+      const char *gradient_id = hb_parc( 6 );
+
+      svg_bbox( svg, x, y, x + width, y + height );
+      svg_printf( svg, SVG_FMT( svg, "<rect x=\"%d\" y=\"%d\" width=\"%d\" height=\"%d\" fill=\"url(#%s)\"/>\n", "<rect x=\"%d\" y=\"%d\" width=\"%d\" height=\"%d\" fill=\"url(#%s)\"/>" ), x, y, width, height, gradient_id );
+   }
+   else
+   {
+      HB_ERR_ARGS();
+   }
+}
+
+/* svg_circle_gradient( <pHandle>, nCx, nCy, nR, cGradient_id ) --> NIL */
+HB_FUNC( SVG_CIRCLE_GRADIENT )
+{
+   SVG *svg = hb_svg_Param( 1 );
+
+   if( svg )
+   {
+      svg_call( svg );
+
+      int cx = hb_parni( 2 );
+      int cy = hb_parni( 3 );
+      int r = hb_parni( 4 );
+      const char *gradient_id = hb_parc( 5 );
+
+      svg_bbox( svg, cx - r, cy - r, cx + r, cy + r );
+      svg_printf( svg, SVG_FMT( svg, "<circle cx=\"%d\" cy=\"%d\" r=\"%d\" fill=\"url(#%s)\"/>\n", "<circle cx=\"%d\" cy=\"%d\" r=\"%d\" fill=\"url(#%s)\"/>" ), cx, cy, r, gradient_id );
+   }
+   else
+   {
+      HB_ERR_ARGS();
+   }
+}
+
+
+/* Spatial index */
+/* svg_hit_test( <pHandle>, <nX>, <nY> ) --> <aIds> */
+HB_FUNC( SVG_HIT_TEST )
+{
+   SVG *svg = hb_svg_Param( 1 );
+
+   if( svg )
+   {
+      int x = hb_parni( 2 );
+      int y = hb_parni( 3 );
+
+      svg_index_return( svg, x, y, x, y );
+   }
+   else
+   {
+      HB_ERR_ARGS();
+   }
+}
+
+/* svg_query_rect( <pHandle>, <nX>, <nY>, <nWidth>, <nHeight> ) --> <aIds> */
+HB_FUNC( SVG_QUERY_RECT )
+{
+   SVG *svg = hb_svg_Param( 1 );
+
+   if( svg )
+   {
+      int x = hb_parni( 2 );
+      int y = hb_parni( 3 );
+      int width = hb_parni( 4 );
+      int height = hb_parni( 5 );
+
+      svg_index_return( svg, x, y, x + width, y + height );
+   }
+   else
+   {
+      HB_ERR_ARGS();
+   }
+}
+
+
+/* Templates */
+/* svg_import( <pHandle>, <cFileName>[, <nDx>, <nDy>, <nScale>, <lMarkup>] ) --> <lOK>
+   With lMarkup .T. the second argument is the SVG markup itself rather than a file name */
+HB_FUNC( SVG_IMPORT )
+{
+   SVG *svg = hb_svg_Param( 1 );
+   const char *filename = hb_parc( 2 );
+
+   if( svg && filename )
+   {
+      SVG_TEMPLATE tpl;
+
+      if( hb_parl( 6 ) )
+      {
+         if( ! svg_template_open_data( &tpl, filename, hb_parclen( 2 ) ) )
+         {
+            fprintf( stderr, "Error: SVG template markup has no outer <svg> element.\n" );
+            hb_retl( HB_FALSE );
+            return;
+         }
+      }
+      else if( ! svg_template_open( &tpl, filename ) )
+      {
+         fprintf( stderr, "Error: Could not read SVG template '%s'.\n", filename );
+         hb_retl( HB_FALSE );
+         return;
+      }
 
-         svg_text( svg, x + label_offset_x, y + label_offset_y, label, "Arial", 12, 400, color );
+      // The key covers the template contents, not only its name
+      if( svg->cache )
+      {
+         svg_cache_call( svg );
+         svg->hash = svg_hash_bytes( svg->hash, tpl.data, tpl.size );
       }
 
-      // Adding labels and tick marks for the vertical arrow
-      label_offset_x = -20;  // Start with a default offset for vertical labels
-      label_offset_y = 0;
-      float dy = ( y1 - y3 ) / ( float ) ( num_labels - 1 );
-      for( int i = 0; i < num_labels; ++i )
+      // The recording carries the markup itself, replay does not read the file again
+      if( svg->recorder )
       {
-         int x = x1;
-         int y = y1 - dy * i;
-         int num = start_num + step * i;
-         char label[ 10 ];
-         sprintf( label, "%d", num );
+         svg_recorder_template( svg->recorder, tpl.data, tpl.size );
+      }
 
-         // Draw tick mark for vertical arrow
-         int tick_length = (i % 5 == 0) ? 10 : 5; // Every fifth tick mark is longer
-         svg_line(svg, x - tick_length, y, x, y, 1, color);
+      double dx = hb_parnd( 3 );
+      double dy = hb_parnd( 4 );
+      double scale = HB_ISNUM( 5 ) ? hb_parnd( 5 ) : 1.0;
+      double width = tpl.width > 0 ? tpl.width : tpl.vb_w;
+      double height = tpl.height > 0 ? tpl.height : tpl.vb_h;
 
-         // Adjust the label offset based on the number of digits
-         int num_digits = strlen( label );
-         label_offset_x = -10 * num_digits;  // Assume each digit is about 10 units wide
+      if( width > 0 && height > 0 )
+      {
+         svg_bbox( svg, ( int ) floor( dx ), ( int ) floor( dy ), ( int ) ceil( dx + width * scale ), ( int ) ceil( dy + height * scale ) );
+      }
+      else
+      {
+         svg_bbox_none( svg );
+      }
 
-         // Additional adjustment for values 100 or greater
-         if( num >= 100 )
+      // The template keeps its own coordinate system: placement, then its viewBox mapping
+      svg_printf( svg, "<g transform=\"translate(%g %g) scale(%g)", dx, dy, scale );
+      if( tpl.has_viewbox )
+      {
+         if( width != tpl.vb_w || height != tpl.vb_h )
          {
-            label_offset_x += 3;
+            svg_printf( svg, " scale(%g %g)", width / tpl.vb_w, height / tpl.vb_h );
          }
-
-         if( num != 0 )  // Skip zero for the vertical arrow
+         if( tpl.vb_x != 0 || tpl.vb_y != 0 )
          {
-            svg_text( svg, x + label_offset_x, y + label_offset_y, label, "Arial", 12, 400, color );
+            svg_printf( svg, " translate(%g %g)", -tpl.vb_x, -tpl.vb_y );
          }
       }
+      svg_printf( svg, "\"" );
+      if( tpl.namespaces.len )
+      {
+         svg_write( svg, tpl.namespaces.data, tpl.namespaces.len );
+      }
+      svg_printf( svg, SVG_FMT( svg, ">\n", ">" ) );
+
+      char prefix[ 32 ];
+      sprintf( prefix, "import%d_", ++svg->imports );
+      svg_template_write( &tpl, prefix, svg_write_func, svg );
+
+      svg_printf( svg, SVG_FMT( svg, "</g>\n", "</g>" ) );
+
+      svg_template_close( &tpl );
+      hb_retl( HB_TRUE );
    }
    else
    {
@@ -564,72 +1914,95 @@ HB_FUNC( SVG_NUMBERED_ARROW_XY )
    }
 }
 
-/* svg_hexagon( <pHandle>, <nHx>, <nHy>, <nR>, <nStroke_width>, <lType>, <nColor> ) --> NIL */
-HB_FUNC( SVG_HEXAGON )
+/* svg_fit_curve( <pHandle>, <aPoints> | <cPacked>, <nTolerance>, <nStroke_width>, <nColor>[, <nCorner_angle>] ) --> nSegments */
+HB_FUNC( SVG_FIT_CURVE )
 {
    SVG *svg = hb_svg_Param( 1 );
+   HB_SIZE count;
+   double *points = svg_param_points( 2, &count );
 
-   if( svg )
+   if( svg && points )
    {
-      int hx = hb_parni( 2 );
-      int hy = hb_parni( 3 );
-      int r = hb_parni( 4 );
-      int stroke_width = hb_parni( 5 );
-      bool type = hb_parl( 6 );
-      unsigned int color = hb_parni( 7 );
-
-      double a = 2 * M_PI / 6;
-      double angle_offset = ( type == 0 ? M_PI_2 : M_PI / 3 ); // Decides the orientation
-      double x1 = hx + r * cos( a * 5 + angle_offset );
-      double y1 = hy + r * sin( a * 5 + angle_offset );
+      svg_call( svg );
 
-      fprintf( svg->file, "<polygon points=\"%.2lf,%.2lf ", x1, y1 );
+      double tolerance = HB_ISNUM( 3 ) ? hb_parnd( 3 ) : 1.0;
+      int stroke_width = hb_parni( 4 );
+      unsigned int color = hb_parni( 5 );
+      double corner_angle = HB_ISNUM( 6 ) ? hb_parnd( 6 ) : 60.0;
+      double *segments;
+      HB_SIZE n = svg_fit_curve( points, count, tolerance > 0 ? tolerance : 1.0, corner_angle, &segments );
 
-      for( int i = 0; i < 6; ++i )
+      if( n )
       {
-         double x = hx + r * cos( a * i + angle_offset );
-         double y = hy + r * sin( a * i + angle_offset );
-         fprintf( svg->file, "%.2lf,%.2lf ", x, y );
+         // The curve stays within the hull of its control points
+         if( svg->index || svg->tiles )
+         {
+            double x0 = points[ 0 ], y0 = points[ 1 ], x1 = x0, y1 = y0;
+
+            for( HB_SIZE i = 0; i < n * 6; i += 2 )
+            {
+               if( segments[ i ] < x0 ) x0 = segments[ i ];
+               if( segments[ i ] > x1 ) x1 = segments[ i ];
+               if( segments[ i + 1 ] < y0 ) y0 = segments[ i + 1 ];
+               if( segments[ i + 1 ] > y1 ) y1 = segments[ i + 1 ];
+            }
+
+            svg_bbox( svg, ( int ) floor( x0 ) - stroke_width / 2, ( int ) floor( y0 ) - stroke_width / 2,
+                      ( int ) ceil( x1 ) + stroke_width / 2, ( int ) ceil( y1 ) + stroke_width / 2 );
+         }
+
+         // Control points are rounded to 1/100 of a unit
+         svg_printf( svg, "<path d=\"M %g %g", round( points[ 0 ] * 100 ) / 100, round( points[ 1 ] * 100 ) / 100 );
+
+         for( HB_SIZE i = 0; i < n * 6; i += 6 )
+         {
+            svg_printf( svg, SVG_FMT( svg, " C %g %g, %g %g, %g %g", " C %g %g,%g %g,%g %g" ),
+                        round( segments[ i ] * 100 ) / 100, round( segments[ i + 1 ] * 100 ) / 100,
+                        round( segments[ i + 2 ] * 100 ) / 100, round( segments[ i + 3 ] * 100 ) / 100,
+                        round( segments[ i + 4 ] * 100 ) / 100, round( segments[ i + 5 ] * 100 ) / 100 );
+         }
+
+         svg_printf( svg, SVG_FMT( svg, "\" stroke=\"%s\"%s fill=\"none\"/>\n", "\" stroke=\"%s\"%s fill=\"none\"/>" ), svg_color( svg, color ), svg_attr( svg, "stroke-width", stroke_width, 1 ) );
+
+         hb_xfree( segments );
       }
 
-      fprintf( svg->file, "\" stroke-width=\"%d\" stroke=\"#%06x\"", stroke_width, color );
-      fprintf( svg->file, " fill=\"none\"/>\n" );
+      hb_xfree( points );
+      hb_retns( n );
    }
    else
    {
+      if( points )
+      {
+         hb_xfree( points );
+      }
       HB_ERR_ARGS();
    }
 }
 
-/* svg_filled_hexagon( <pHandle>, <nHx>, <nHy>, <nR>, <lType>, <nColor> ) --> NIL */
-HB_FUNC( SVG_FILLED_HEXAGON )
+/* svg_path_begin( <pHandle>[, <hStyle>] ) --> NIL
+   hStyle keys: "stroke" colour, "stroke_width", "fill" colour ( none when missing ).
+   Tiled handles buffer the whole path until svg_path_end(). */
+HB_FUNC( SVG_PATH_BEGIN )
 {
    SVG *svg = hb_svg_Param( 1 );
 
    if( svg )
    {
-      int hx = hb_parni( 2 );
-      int hy = hb_parni( 3 );
-      int r = hb_parni( 4 );
-      bool type = hb_parl( 5 );
-      unsigned int color = hb_parni( 6 );
+      svg_call( svg );
 
-      double a = 2 * M_PI / 6;
-      double angle_offset = ( type == 0 ? M_PI_2 : M_PI / 3 ); // Decides the orientation
-      double x1 = hx + r * cos( a * 5 + angle_offset );
-      double y1 = hy + r * sin( a * 5 + angle_offset );
+      PHB_ITEM pStyle = hb_param( 2, HB_IT_HASH );
 
-      fprintf( svg->file, "<polygon points=\"%.2lf,%.2lf ", x1, y1 );
+      // Ends a path left open and starts a new element; the box follows in svg_path_end()
+      svg_bbox_none( svg );
 
-      for( int i = 0; i < 6; ++i )
-      {
-         double x = hx + r * cos( a * i + angle_offset );
-         double y = hy + r * sin( a * i + angle_offset );
-         fprintf( svg->file, "%.2lf,%.2lf ", x, y );
-      }
+      memset( &svg->path, 0, sizeof( SVG_PATH ) );
+      svg->path.open = T;
+      svg->path.stroke = ( unsigned int ) svg_hash_ni( pStyle, "stroke", 0x000000 );
+      svg->path.stroke_width = svg_hash_ni( pStyle, "stroke_width", 1 );
+      svg->path.fill = svg_hash_ni( pStyle, "fill", -1 );
 
-      fprintf( svg->file, "\" stroke=\"#%06x\" stroke-width=\"1\"", color );
-      fprintf( svg->file, " fill=\"#%06x\"/>\n", color );
+      svg_printf( svg, "<path d=\"" );
    }
    else
    {
@@ -637,21 +2010,21 @@ HB_FUNC( SVG_FILLED_HEXAGON )
    }
 }
 
-/* svg_ellipse( <pHandle>, <nCx>, <nCy>, <nRx>, <nRy>, <nStroke_width>, <nColor> ) --> NIL */
-HB_FUNC( SVG_ELLIPSE )
+/* svg_path_moveto( <pHandle>, <nX>, <nY> ) --> NIL */
+HB_FUNC( SVG_PATH_MOVETO )
 {
    SVG *svg = hb_svg_Param( 1 );
 
-   if( svg )
+   if( svg && svg->path.open )
    {
-      int cx = hb_parni( 2 );
-      int cy = hb_parni( 3 );
-      int rx = hb_parni( 4 );
-      int ry = hb_parni( 5 );
-      int stroke_width = hb_parni( 6 );
-      unsigned int color = hb_parni( 7 );
+      svg_call( svg );
 
-      fprintf( svg->file, "<ellipse cx=\"%d\" cy=\"%d\" rx=\"%d\" ry=\"%d\" stroke=\"#%06x\" stroke-width=\"%d\" fill=\"none\"/>\n", cx, cy, rx, ry, color, stroke_width );
+      double x = hb_parnd( 2 );
+      double y = hb_parnd( 3 );
+
+      svg_path_extend( &svg->path, x, y );
+      svg->path.current = T;
+      svg_printf( svg, "%sM %g %g", svg_path_separator( &svg->path ), x, y );
    }
    else
    {
@@ -659,65 +2032,51 @@ HB_FUNC( SVG_ELLIPSE )
    }
 }
 
-/* svg_filled_ellipse( <pHandle>, <nCx>, <nCy>, <nRx>, <nRy>, <nColor> ) --> NIL */
-HB_FUNC( SVG_FILLED_ELLIPSE )
+/* svg_path_lineto( <pHandle>, <nX>, <nY> ) --> NIL */
+HB_FUNC( SVG_PATH_LINETO )
 {
    SVG *svg = hb_svg_Param( 1 );
 
-   if( svg )
+   if( svg && svg->path.open )
    {
-      int cx = hb_parni( 2 );
-      int cy = hb_parni( 3 );
-      int rx = hb_parni( 4 );
-      int ry = hb_parni( 5 );
-      unsigned int color = hb_parni( 6 );
+      svg_call( svg );
+
+      double x = hb_parnd( 2 );
+      double y = hb_parnd( 3 );
 
-      fprintf( svg->file, "<ellipse cx=\"%d\" cy=\"%d\" rx=\"%d\" ry=\"%d\" fill=\"#%06x\"/>\n", cx, cy, rx, ry, color );
+      svg_path_extend( &svg->path, x, y );
+      svg_printf( svg, "%s%c %g %g", svg_path_separator( &svg->path ), svg->path.current ? 'L' : 'M', x, y );
+      svg->path.current = T;
    }
    else
    {
       HB_ERR_ARGS();
    }
 }
-/* svg_bezier_curve( <pHandle>, <aPoints>, <nPoint_count>, <nStroke_width>, <nColor> ) --> NIL */
-HB_FUNC( SVG_BEZIER_CURVE )
+
+/* svg_path_curveto( <pHandle>, <nX1>, <nY1>, <nX2>, <nY2>, <nX>, <nY> ) --> NIL */
+HB_FUNC( SVG_PATH_CURVETO )
 {
    SVG *svg = hb_svg_Param( 1 );
-   PHB_ITEM pItem;
 
-   if( svg && ( pItem = hb_param( 2, HB_IT_ARRAY ) ) != NULL )
+   if( svg && svg->path.open && svg->path.current )
    {
-      int point_count = hb_parni( 3 );
-      int stroke_width = hb_parni( 4 );
-      unsigned int color = hb_parni( 5 );
+      svg_call( svg );
 
-      point_count = ( int ) hb_arrayLen( pItem );
-      int *points = NULL;
-
-      if( point_count )
-      {
-         points = ( int * ) hb_xgrab( point_count * sizeof( int ) );
-      }
+      double points[ 6 ];
 
-      // Retrieving elements from the Harbour array into the points array
-      for( int i = 0; i < point_count; ++i )
+      for( int i = 0; i < 6; ++i )
       {
-         points[ i ] = hb_arrayGetNI( pItem, ( HB_SIZE ) i + 1 );
+         points[ i ] = hb_parnd( i + 2 );
       }
 
-      fprintf( svg->file, "<path d=\"M %d %d ", points[ 0 ], points[ 1 ] );
-
-      for( int i = 2; i < point_count; i += 6 )
+      // A cubic Bezier never leaves the hull of its control points
+      for( int i = 0; i < 6; i += 2 )
       {
-         fprintf( svg->file, "C %d %d, %d %d, %d %d ", points[ i ], points[ i + 1 ], points[ i + 2 ], points[ i + 3 ], points[ i + 4 ], points[ i + 5 ] );
+         svg_path_extend( &svg->path, points[ i ], points[ i + 1 ] );
       }
 
-      fprintf( svg->file, "\" stroke=\"#%06x\" stroke-width=\"%d\" fill=\"none\"/>\n", color, stroke_width );
-
-      if( points )
-      {
-         hb_xfree( points );
-      }
+      svg_printf( svg, SVG_FMT( svg, "%sC %g %g, %g %g, %g %g", "%sC %g %g,%g %g,%g %g" ), svg_path_separator( &svg->path ), points[ 0 ], points[ 1 ], points[ 2 ], points[ 3 ], points[ 4 ], points[ 5 ] );
    }
    else
    {
@@ -725,22 +2084,16 @@ HB_FUNC( SVG_BEZIER_CURVE )
    }
 }
 
-// void svg_text( SVG *svg, int x, int y, const char *text, const char *font, int size, int font_weight, unsigned int color );
-HB_FUNC( SVG_TEXT )
+/* svg_path_close( <pHandle> ) --> NIL */
+HB_FUNC( SVG_PATH_CLOSE )
 {
    SVG *svg = hb_svg_Param( 1 );
 
-   if( svg )
+   if( svg && svg->path.open )
    {
-      int x = hb_parni( 2 );
-      int y = hb_parni( 3 );
-      const char *text = hb_parc( 4 );
-      const char *font = hb_parc( 5 );
-      int size = hb_parni( 6 );
-      int font_weight = hb_parni( 7 );
-      unsigned int color = hb_parni( 8 );
+      svg_call( svg );
 
-      svg_text( svg, x, y, text, font, size, font_weight, color );
+      svg_printf( svg, "%sZ", svg_path_separator( &svg->path ) );
    }
    else
    {
@@ -748,28 +2101,44 @@ HB_FUNC( SVG_TEXT )
    }
 }
 
-/* Linear gradient */
-/* svg_linear_gradient( <pHandle>, <cId>, <nStartColor>, <nEndColor>, <nX1>, <nY1>, <nX2>, <nY2> ) --> NIL */
-HB_FUNC( SVG_LINEAR_GRADIENT )
+/* svg_path_points( <pHandle>, <cPacked> ) --> NIL
+   cPacked holds 32-bit little-endian x, y pairs ( L2Bin( x ) + L2Bin( y ) + ... ),
+   drawn as lines from the current point */
+HB_FUNC( SVG_PATH_POINTS )
 {
    SVG *svg = hb_svg_Param( 1 );
+   const char *data = hb_parc( 2 );
 
-   if( svg )
+   if( svg && svg->path.open && data )
    {
-      const char *id = hb_parc( 2 );
-      unsigned int startColor = hb_parni( 3 );
-      unsigned int endColor = hb_parni( 4 );
-      float x1 = hb_parnd( 5 );
-      float y1 = hb_parnd( 6 );
-      float x2 = hb_parnd( 7 );
-      float y2 = hb_parnd( 8 );
+      svg_call( svg );
+
+      HB_SIZE count = hb_parclen( 2 ) / 8;
+      SVG_PATH *path = &svg->path;
+      char buffer[ 4096 ];
+      HB_SIZE len = 0;
+
+      // Formatted in blocks straight from the string, nothing is copied per point
+      for( HB_SIZE i = 0; i < count; ++i, data += 8 )
+      {
+         int x = HB_GET_LE_INT32( data );
+         int y = HB_GET_LE_INT32( data + 4 );
+
+         svg_path_extend( path, x, y );
+         len += sprintf( buffer + len, "%s%c %d %d", svg_path_separator( path ), path->current ? 'L' : 'M', x, y );
+         path->current = T;
+
+         if( len > sizeof( buffer ) - 32 )
+         {
+            svg_write( svg, buffer, len );
+            len = 0;
+         }
+      }
 
-      fprintf( svg->file, "<defs>\n" );
-      fprintf( svg->file, "<linearGradient id=\"%s\" x1=\"%f%%\" y1=\"%f%%\" x2=\"%f%%\" y2=\"%f%%\">\n", id, x1, y1, x2, y2 );
-      fprintf( svg->file, "<stop offset=\"0%%\" style=\"stop-color:#%06x;stop-opacity:1\" />\n", startColor );
-      fprintf( svg->file, "<stop offset=\"100%%\" style=\"stop-color:#%06x;stop-opacity:1\" />\n", endColor );
-      fprintf( svg->file, "</linearGradient>\n" );
-      fprintf( svg->file, "</defs>\n" );
+      if( len )
+      {
+         svg_write( svg, buffer, len );
+      }
    }
    else
    {
@@ -777,35 +2146,16 @@ HB_FUNC( SVG_LINEAR_GRADIENT )
    }
 }
 
-/* svg_triangle_linear_gradient( <pHandle>, <nX1>, <nY1>, <nX2>, <nY2>, <nX3>, <nY3>, <nStartColor>, <nEndColor> ) --> NIL */ // to be fixed
-HB_FUNC( SVG_TRIANGLE_LINEAR_GRADIENT )
+/* svg_path_end( <pHandle> ) --> NIL */
+HB_FUNC( SVG_PATH_END )
 {
    SVG *svg = hb_svg_Param( 1 );
 
-   if( svg )
+   if( svg && svg->path.open )
    {
-      int x1 = hb_parni( 2 );
-      int y1 = hb_parni( 3 );
-      int x2 = hb_parni( 4 );
-      int y2 = hb_parni( 5 );
-      int x3 = hb_parni( 6 );
-      int y3 = hb_parni( 7 );
-      unsigned int startColor = hb_parni( 8 );
-      unsigned int endColor = hb_parni( 9 );
-
-      // Definition of a linear gradient triangle
-      static int gradient_id = 0;
-      fprintf( svg->file, "<defs>\n" );
-      fprintf( svg->file, "  <linearGradient id=\"triangleGradient%d\" x1=\"0%%\" y1=\"0%%\" x2=\"100%%\" y2=\"0%%\">\n", gradient_id );
-      fprintf( svg->file, "    <stop offset=\"0%%\" style=\"stop-color:#%06x;stop-opacity:1\" />\n", startColor );
-      fprintf( svg->file, "    <stop offset=\"100%%\" style=\"stop-color:#%06x;stop-opacity:1\" />\n", endColor );
-      fprintf( svg->file, "  </linearGradient>\n" );
-      fprintf( svg->file, "</defs>\n" );
-
-      // Drawing a triangle with a gradient
-      fprintf( svg->file, "<polygon points=\"%d,%d %d,%d %d,%d\" fill=\"url(#triangleGradient%d)\"/>\n", x1, y1, x2, y2, x3, y3, gradient_id );
+      svg_call( svg );
 
-      gradient_id++; // Increment the gradient ID
+      svg_path_finish( svg );
    }
    else
    {
@@ -813,27 +2163,19 @@ HB_FUNC( SVG_TRIANGLE_LINEAR_GRADIENT )
    }
 }
 
-/* Radial gradient */
-/* svg_radial_gradient( <pHandle>, cId, nInnerColor, nOuterColor, nCx, nCy, nR ) --> NIL */
-HB_FUNC( SVG_RADIAL_GRADIENT )
+/* svg_set_cache_dir( <cDir>[, <nMemoryLimit>] ) --> NIL
+   Directory of documents reused by handles opened with SVG_FLAG_CACHE, empty to disable.
+   A cached document is kept in memory until svg_close() knows its key; past nMemoryLimit
+   bytes ( 16 MB by default, 0 for no limit ) it goes to a temporary file, which a cache
+   hit then deletes, so such documents pay for one full write even when reused. */
+HB_FUNC( SVG_SET_CACHE_DIR )
 {
-   SVG *svg = hb_svg_Param( 1 );
+   const char *dir = hb_parc( 1 );
+   HB_MAXINT limit = HB_ISNUM( 2 ) ? hb_parnint( 2 ) : SVG_CACHE_SPILL;
 
-   if( svg )
+   if( dir && limit >= 0 )
    {
-      const char *id = hb_parc( 2 );
-      unsigned int innerColor = hb_parni( 3 );
-      unsigned int outerColor = hb_parni( 4 );
-      float cx = hb_parnd( 5 );
-      float cy = hb_parnd( 6 );
-      float r = hb_parnd( 7 );
-
-      fprintf( svg->file, "<defs>\n" );
-      fprintf( svg->file, "<radialGradient id=\"%s\" cx=\"%f%%\" cy=\"%f%%\" r=\"%f%%\">\n", id, cx, cy, r );
-      fprintf( svg->file, "<stop offset=\"0%%\" style=\"stop-color:#%06x;stop-opacity:1\"/>\n", innerColor );
-      fprintf( svg->file, "<stop offset=\"100%%\" style=\"stop-color:#%06x;stop-opacity:1\"/>\n", outerColor );
-      fprintf( svg->file, "</radialGradient>\n" );
-      fprintf( svg->file, "</defs>\n" );
+      svg_cache_set_dir( dir, ( HB_SIZE ) limit );
    }
    else
    {
@@ -841,56 +2183,199 @@ HB_FUNC( SVG_RADIAL_GRADIENT )
    }
 }
 
-/* svg_triangle_radial_gradient( <pHandle>, <nX1>, <nY1>, <nX2>, <nY2>, <nX3>, <nY3>, <nStartColor>, <nEndColor> ) --> NIL */ // to be fixed
-HB_FUNC( SVG_TRIANGLE_RADIAL_GRADIENT )
+/* Tick distance of 1, 2 or 5 times a power of ten giving about ticks intervals */
+static double svg_nice_step( double range, int ticks )
 {
-   SVG *svg = hb_svg_Param( 1 );
+   double raw = range / ( ticks > 0 ? ticks : 1 );
+   double magnitude = pow( 10, floor( log10( raw ) ) );
+   double fraction = raw / magnitude;
+
+   if( fraction <= 1 )
+      fraction = 1;
+   else if( fraction <= 2 )
+      fraction = 2;
+   else if( fraction <= 5 )
+      fraction = 5;
+   else
+      fraction = 10;
 
-   if( svg )
+   return fraction * magnitude;
+}
+
+/* Axis from a whole number of steps below min to a whole number above max */
+static int svg_axis_range( double min, double max, int ticks, double *start, double *step )
+{
+   if( !( max > min ) )
    {
-      int x1 = hb_parni( 2 );
-      int y1 = hb_parni( 3 );
-      int x2 = hb_parni( 4 );
-      int y2 = hb_parni( 5 );
-      int x3 = hb_parni( 6 );
-      int y3 = hb_parni( 7 );
-      unsigned int startColor = hb_parni( 8 );
-      unsigned int endColor = hb_parni( 9 );
+      // Flat or empty data still gets a unit range
+      double pad = fabs( min ) > 0 ? fabs( min ) / 2 : 1;
 
-      // Definition of a radial gradient triangle
-      static int gradient_id = 0;
-      fprintf( svg->file, "<defs>\n" );
-      fprintf( svg->file, "  <radialGradient id=\"triangleRadialGradient%d\" cx=\"50%%\" cy=\"50%%\" r=\"50%%\">\n", gradient_id );
-      fprintf( svg->file, "    <stop offset=\"0%%\" style=\"stop-color:#%06x;stop-opacity:1\" />\n", startColor );
-      fprintf( svg->file, "    <stop offset=\"100%%\" style=\"stop-color:#%06x;stop-opacity:1\" />\n", endColor );
-      fprintf( svg->file, "  </radialGradient>\n" );
-      fprintf( svg->file, "</defs>\n" );
+      min -= pad;
+      max += pad;
+   }
 
-      // Drawing a triangle with a gradient
-      fprintf( svg->file, "<polygon points=\"%d,%d %d,%d %d,%d\" fill=\"url(#triangleRadialGradient%d)\"/>\n", x1, y1, x2, y2, x3, y3, gradient_id );
+   *step = svg_nice_step( max - min, ticks );
+   *start = floor( min / *step ) * *step;
 
-      gradient_id++; // Increment the gradient ID
-   }
-   else
-   {
-      HB_ERR_ARGS();
-   }
+   int num_labels = ( int ) ceil( ( max - *start ) / *step - 1e-9 ) + 1;
+
+   return num_labels > 2 ? num_labels : 2;
 }
 
-/* svg_rect_gradient( <pHandle>, nX, nY, nWidth, nHeight, cGradient_id ) */
-HB_FUNC( SVG_RECT_GRADIENT )
+/* Chart coordinate rounded to whole units, far-off values kept within the range of int */
+static int svg_plot_coord( double value )
 {
-   SVG *svg = hb_svg_Param( 1 );
+   if( !( value > -1e7 ) )
+      return -10000000;
+   if( value > 1e7 )
+      return 10000000;
 
-   if( svg )
+   return ( int ) floor( value + 0.5 );
+}
+
+/* svg_line_chart( <pHandle>, <aSeries> | <cPacked>[, <hOptions>] ) --> nPoints
+   aSeries: a flat { x1, y1, x2, y2, ... } array for one series, or an array of series,
+   each a flat array or a packed string of 32-bit x, y pairs; cPacked is a single series.
+   hOptions: "x", "y", "width", "height" of the plot area, "points" budget of each series
+   ( plot width ), "method" "lttb" or "minmax", "colors" array, "stroke_width",
+   "axis_color", "ticks", "y_min", "y_max". Returns the number of points written.
+   Series are clipped to the plot area, which must not be empty. */
+HB_FUNC( SVG_LINE_CHART )
+{
+   SVG *svg = hb_svg_Param( 1 );
+   PHB_ITEM pSeries = hb_param( 2, HB_IT_ARRAY | HB_IT_STRING );
+   PHB_ITEM pOptions = hb_param( 3, HB_IT_HASH );
+   int x = svg_hash_ni( pOptions, "x", 60 );
+   int y = svg_hash_ni( pOptions, "y", 20 );
+   int width = svg ? svg_hash_ni( pOptions, "width", svg->width - x - 30 ) : 0;
+   int height = svg ? svg_hash_ni( pOptions, "height", svg->height - y - 40 ) : 0;
+
+   if( svg && pSeries && width > 0 && height > 0 )
    {
-      int x = hb_parni( 2 );
-      int y = hb_parni( 3 );
-      int width = hb_parni( 4 );
-      int height = hb_parni( 5 );
-      const char *gradient_id = hb_parc( 6 );
+      svg_call( svg );
+
+      static const unsigned int s_palette[] = { 0x3848AA, 0xFF0000, 0x2E8B57, 0xFFA500, 0x800080, 0x008080 };
+      PHB_ITEM pColors = pOptions ? hb_hashGetCItemPtr( pOptions, "colors" ) : NULL;
+      PHB_ITEM pMethod = pOptions ? hb_hashGetCItemPtr( pOptions, "method" ) : NULL;
+      int stroke_width = svg_hash_ni( pOptions, "stroke_width", 1 );
+      int ticks = svg_hash_ni( pOptions, "ticks", 10 );
+      unsigned int axis_color = ( unsigned int ) svg_hash_ni( pOptions, "axis_color", 0x000000 );
+      bool minmax = pMethod && HB_IS_STRING( pMethod ) && strcmp( hb_itemGetCPtr( pMethod ), "minmax" ) == 0;
+      HB_SIZE budget = ( HB_SIZE ) svg_hash_ni( pOptions, "points", minmax ? width * 2 : width );
+      HB_SIZE written = 0;
+
+      // One flat array or string is a single series
+      bool single = HB_IS_STRING( pSeries ) || ( hb_arrayLen( pSeries ) > 0 && HB_IS_NUMERIC( hb_arrayGetItemPtr( pSeries, 1 ) ) );
+      HB_SIZE num_series = single ? 1 : hb_arrayLen( pSeries );
+      double **data = ( double ** ) hb_xgrab( ( num_series + 1 ) * sizeof( double * ) );
+      HB_SIZE *counts = ( HB_SIZE * ) hb_xgrab( ( num_series + 1 ) * sizeof( HB_SIZE ) );
+      double x_min = 0, x_max = 0, y_min = 0, y_max = 0;
+      bool empty = T;
+
+      for( HB_SIZE s = 0; s < num_series; ++s )
+      {
+         data[ s ] = svg_item_points( single ? pSeries : hb_arrayGetItemPtr( pSeries, s + 1 ), &counts[ s ] );
+
+         for( HB_SIZE i = 0; i < counts[ s ]; ++i )
+         {
+            double px = data[ s ][ i * 2 ];
+            double py = data[ s ][ i * 2 + 1 ];
+
+            if( empty )
+            {
+               x_min = x_max = px;
+               y_min = y_max = py;
+               empty = F;
+            }
+            else
+            {
+               if( px < x_min ) x_min = px;
+               if( px > x_max ) x_max = px;
+               if( py < y_min ) y_min = py;
+               if( py > y_max ) y_max = py;
+            }
+         }
+      }
+
+      double data_y_min = y_min, data_y_max = y_max;
+
+      y_min = svg_hash_nd( pOptions, "y_min", y_min );
+      y_max = svg_hash_nd( pOptions, "y_max", y_max );
+
+      double x_start, x_step, y_start, y_step;
+      int x_labels = svg_axis_range( x_min, x_max, ticks, &x_start, &x_step );
+      int y_labels = svg_axis_range( y_min, y_max, ticks, &y_start, &y_step );
+      double x_scale = width / ( x_step * ( x_labels - 1 ) );
+      double y_scale = height / ( y_step * ( y_labels - 1 ) );
+      int clip_id = -1;
+
+      // A y_min or y_max inside the data leaves points outside the axes, only then the series are clipped
+      if( ! empty && ( data_y_min < y_start || data_y_max > y_start + y_step * ( y_labels - 1 ) ) )
+      {
+         clip_id = svg->clip_paths++;
+         svg_bbox_none( svg );
+         svg_printf( svg, SVG_FMT( svg, "<defs><clipPath id=\"plotClip%d\"><rect x=\"%d\" y=\"%d\" width=\"%d\" height=\"%d\"/></clipPath></defs>\n", "<defs><clipPath id=\"plotClip%d\"><rect x=\"%d\" y=\"%d\" width=\"%d\" height=\"%d\"/></clipPath></defs>" ),
+                     clip_id, x, y, width, height );
+      }
+
+      // Labels stay within about 60 units of the axes, like svg_numbered_arrow_xy()
+      int points[ 6 ] = { x + width, y + height, x, y + height, x, y };
+
+      svg_bbox_points( svg, points, 6, 120 );
 
-      fprintf( svg->file, "<rect x=\"%d\" y=\"%d\" width=\"%d\" height=\"%d\" fill=\"url(#%s)\"/>\n", x, y, width, height, gradient_id );
+      svg_arrow( svg, x, y + height, x + width, y + height, 1, axis_color );
+      svg_arrow( svg, x, y + height, x, y, 1, axis_color );
+      svg_ticks_x( svg, x, y + height, x + width, x_start, x_step, x_labels, axis_color );
+      svg_ticks_y( svg, x, y + height, y, y_start, y_step, y_labels, F, axis_color );
+
+      for( HB_SIZE s = 0; s < num_series; ++s )
+      {
+         HB_SIZE count = counts[ s ];
+
+         if( count == 0 )
+            continue;
+
+         HB_SIZE limit = budget < count ? budget : count;
+         HB_SIZE *selected = ( HB_SIZE * ) hb_xgrab( ( limit + 1 ) * sizeof( HB_SIZE ) );
+         HB_SIZE n = minmax ? svg_downsample_minmax( data[ s ], count, budget, selected ) : svg_downsample_lttb( data[ s ], count, budget, selected );
+         unsigned int color = s_palette[ s % HB_SIZEOFARRAY( s_palette ) ];
+
+         if( pColors && HB_IS_ARRAY( pColors ) && hb_arrayLen( pColors ) > 0 )
+         {
+            color = ( unsigned int ) hb_arrayGetNI( pColors, s % hb_arrayLen( pColors ) + 1 );
+         }
+
+         svg_printf( svg, "<polyline points=\"" );
+
+         for( HB_SIZE i = 0; i < n; ++i )
+         {
+            const double *p = data[ s ] + selected[ i ] * 2;
+
+            svg_printf( svg, i ? " %d,%d" : "%d,%d", svg_plot_coord( x + ( p[ 0 ] - x_start ) * x_scale ), svg_plot_coord( y + height - ( p[ 1 ] - y_start ) * y_scale ) );
+         }
+
+         svg_printf( svg, "\"%s stroke=\"%s\" fill=\"none\"", svg_attr( svg, "stroke-width", stroke_width, 1 ), svg_color( svg, color ) );
+         if( clip_id >= 0 )
+         {
+            svg_printf( svg, " clip-path=\"url(#plotClip%d)\"", clip_id );
+         }
+         svg_printf( svg, SVG_FMT( svg, "/>\n", "/>" ) );
+
+         written += n;
+         hb_xfree( selected );
+      }
+
+      for( HB_SIZE s = 0; s < num_series; ++s )
+      {
+         if( data[ s ] )
+         {
+            hb_xfree( data[ s ] );
+         }
+      }
+      hb_xfree( data );
+      hb_xfree( counts );
+
+      hb_retns( written );
    }
    else
    {
@@ -898,19 +2383,16 @@ HB_FUNC( SVG_RECT_GRADIENT )
    }
 }
 
-/* svg_circle_gradient( <pHandle>, nCx, nCy, nR, cGradient_id ) --> NIL */
-HB_FUNC( SVG_CIRCLE_GRADIENT )
+/* svg_replay( <cBinFile>, <cSvgFile> ) --> <lOK> */
+/* Writes <cSvgFile> from the calls recorded with SVG_FLAG_RECORD */
+HB_FUNC( SVG_REPLAY )
 {
-   SVG *svg = hb_svg_Param( 1 );
+   const char *binfile = hb_parc( 1 );
+   const char *svgfile = hb_parc( 2 );
 
-   if( svg )
+   if( binfile && svgfile )
    {
-      int cx = hb_parni( 2 );
-      int cy = hb_parni( 3 );
-      int r = hb_parni( 4 );
-      const char *gradient_id = hb_parc( 5 );
-
-      fprintf( svg->file, "<circle cx=\"%d\" cy=\"%d\" r=\"%d\" fill=\"url(#%s)\"/>\n", cx, cy, r, gradient_id );
+      hb_retl( svg_replay_file( binfile, svgfile ) );
    }
    else
    {
@@ -0,0 +1,138 @@
+/*
+ * Harbour Scalable Vector Graphics (HBSVG) Project
+ * Copyright 2014 - 2024 Rafał Jopek
+ * Website: https://harbour.pl
+ *
+ */
+
+#include "hbsvg.h"
+
+#if defined( HB_OS_UNIX )
+   #include <fcntl.h>
+   #include <sys/mman.h>
+   #include <sys/stat.h>
+   #include <unistd.h>
+#endif
+
+/* ------------------------------------------------------------------------- */
+void svg_buffer_reserve( SVG_BUFFER *buffer, HB_SIZE size )
+{
+   if( buffer->len + size > buffer->capacity )
+   {
+      HB_SIZE capacity = buffer->capacity ? buffer->capacity : 256;
+
+      while( capacity < buffer->len + size )
+      {
+         capacity *= 2;
+      }
+
+      buffer->data = ( char * ) hb_xrealloc( buffer->data, capacity );
+      buffer->capacity = capacity;
+   }
+}
+
+void svg_buffer_append( SVG_BUFFER *buffer, const char *data, HB_SIZE len )
+{
+   svg_buffer_reserve( buffer, len );
+   memcpy( buffer->data + buffer->len, data, len );
+   buffer->len += len;
+}
+
+void svg_buffer_vprintf( SVG_BUFFER *buffer, const char *format, va_list args )
+{
+   va_list copy;
+   int len;
+
+   // Most elements fit into the spare capacity, so format in place first
+   svg_buffer_reserve( buffer, 128 );
+
+   va_copy( copy, args );
+   len = vsnprintf( buffer->data + buffer->len, buffer->capacity - buffer->len, format, copy );
+   va_end( copy );
+
+   if( len < 0 )
+      return;
+
+   if( ( HB_SIZE ) len >= buffer->capacity - buffer->len )
+   {
+      svg_buffer_reserve( buffer, ( HB_SIZE ) len + 1 );
+      vsnprintf( buffer->data + buffer->len, buffer->capacity - buffer->len, format, args );
+   }
+
+   buffer->len += len;
+}
+
+void svg_buffer_free( SVG_BUFFER *buffer )
+{
+   if( buffer->data )
+   {
+      hb_xfree( buffer->data );
+   }
+   buffer->data = NULL;
+   buffer->len = 0;
+   buffer->capacity = 0;
+}
+
+/* Read-only view of a whole file: memory-mapped where available, read into
+   memory otherwise. Returns NULL for missing or empty files. */
+const char *svg_file_map( const char *filename, HB_SIZE *size )
+{
+#if defined( HB_OS_UNIX )
+   int fd = open( filename, O_RDONLY );
+   struct stat st;
+
+   if( fd == -1 )
+      return NULL;
+
+   if( fstat( fd, &st ) != 0 || st.st_size == 0 )
+   {
+      close( fd );
+      return NULL;
+   }
+
+   void *map = mmap( NULL, ( size_t ) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+   close( fd );
+
+   if( map == MAP_FAILED )
+      return NULL;
+
+   madvise( map, ( size_t ) st.st_size, MADV_SEQUENTIAL );
+
+   *size = ( HB_SIZE ) st.st_size;
+   return ( const char * ) map;
+#else
+   FILE *file = fopen( filename, "rb" );
+   long len;
+
+   if( file == NULL )
+      return NULL;
+
+   if( fseek( file, 0, SEEK_END ) != 0 || ( len = ftell( file ) ) <= 0 || fseek( file, 0, SEEK_SET ) != 0 )
+   {
+      fclose( file );
+      return NULL;
+   }
+
+   char *data = ( char * ) hb_xgrab( ( HB_SIZE ) len );
+   if( fread( data, 1, ( size_t ) len, file ) != ( size_t ) len )
+   {
+      hb_xfree( data );
+      fclose( file );
+      return NULL;
+   }
+   fclose( file );
+
+   *size = ( HB_SIZE ) len;
+   return data;
+#endif
+}
+
+void svg_file_unmap( const char *data, HB_SIZE size )
+{
+#if defined( HB_OS_UNIX )
+   munmap( ( void * ) data, ( size_t ) size );
+#else
+   HB_SYMBOL_UNUSED( size );
+   hb_xfree( ( void * ) data );
+#endif
+}
@@ -0,0 +1,378 @@
+/*
+ * Harbour Scalable Vector Graphics (HBSVG) Project
+ * Copyright 2014 - 2024 Rafał Jopek
+ * Website: https://harbour.pl
+ *
+ */
+
+/*
+ * Content-addressed document cache.
+ *
+ * A handle opened with SVG_FLAG_CACHE folds the name and the arguments of
+ * every drawing call into a 64-bit hash (wyhash-style multiply-fold mixing),
+ * so two runs issuing the same calls end with the same key. Queries write
+ * nothing and are left out.
+ *
+ * The key is known only at svg_close(), so the document is kept in memory
+ * until then, or in a temporary file in the cache directory once it outgrows
+ * the memory limit of svg_set_cache_dir() ( SVG_CACHE_SPILL by default, 0 for
+ * none ). If <dir>/<key>.svg exists by then, the new output is discarded;
+ * a document that was spilled has still paid for writing it once. Otherwise
+ * the output becomes that entry. Either way
+ * the requested file is a hard link to the entry, or a copy where links are
+ * not available.
+ */
+
+#include "hbsvg.h"
+
+#if defined( HB_OS_UNIX )
+   #include <sys/stat.h>
+   #include <unistd.h>
+#endif
+
+#define SVG_HASH_P0      0xa0761d6478bd642fULL
+#define SVG_HASH_P1      0xe7037ed1a0b428dbULL
+
+static HB_CRITICAL_NEW( s_cacheMtx );
+static char *s_cacheDir = NULL;
+static HB_SIZE s_cacheLimit = SVG_CACHE_SPILL;
+static HB_U32 s_tempCount = 0;
+
+/* ------------------------------------------------------------------------- */
+// static
+/* 64 x 64 -> 128-bit multiply, high and low halves folded together */
+static HB_U64 svg_hash_mum( HB_U64 a, HB_U64 b )
+{
+#if defined( __SIZEOF_INT128__ )
+   unsigned __int128 r = ( unsigned __int128 ) a * b;
+
+   return ( HB_U64 ) r ^ ( HB_U64 ) ( r >> 64 );
+#else
+   HB_U64 ha = a >> 32, la = ( HB_U32 ) a;
+   HB_U64 hb = b >> 32, lb = ( HB_U32 ) b;
+   HB_U64 rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+   HB_U64 t = rl + ( rm0 << 32 );
+   HB_U64 lo = t + ( rm1 << 32 );
+   HB_U64 hi = rh + ( rm0 >> 32 ) + ( rm1 >> 32 ) + ( t < rl ) + ( lo < t );
+
+   return lo ^ hi;
+#endif
+}
+
+static void svg_cache_path( char *buffer, const char *dir, const char *name )
+{
+   HB_SIZE len = strlen( dir );
+
+   strcpy( buffer, dir );
+   if( len && dir[ len - 1 ] != '/' && dir[ len - 1 ] != '\\' )
+   {
+      strcat( buffer, "/" );
+   }
+   strcat( buffer, name );
+}
+
+static bool svg_cache_exists( const char *filename )
+{
+   FILE *file = fopen( filename, "rb" );
+
+   if( file )
+   {
+      fclose( file );
+      return T;
+   }
+   return F;
+}
+
+/* Makes filename refer to the cache entry */
+static bool svg_cache_publish( const char *cached, const char *filename )
+{
+   remove( filename );
+
+#if defined( HB_OS_UNIX )
+   if( link( cached, filename ) == 0 )
+      return T;
+#endif
+
+   FILE *src = fopen( cached, "rb" );
+   FILE *dst;
+   bool ok = T;
+
+   if( src == NULL )
+      return F;
+
+   dst = fopen( filename, "wb" );
+   if( dst == NULL )
+   {
+      fprintf( stderr, "Error: Could not open file '%s' for writing.\n", filename );
+      fclose( src );
+      return F;
+   }
+
+   char *buffer = ( char * ) hb_xgrab( 0x10000 );
+   size_t len;
+
+   while( ok && ( len = fread( buffer, 1, 0x10000, src ) ) > 0 )
+   {
+      ok = fwrite( buffer, 1, len, dst ) == len;
+   }
+
+   hb_xfree( buffer );
+   fclose( src );
+   if( fclose( dst ) != 0 )
+      ok = F;
+
+   return ok;
+}
+
+/* ------------------------------------------------------------------------- */
+HB_U64 svg_hash_u64( HB_U64 hash, HB_U64 value )
+{
+   return svg_hash_mum( hash ^ SVG_HASH_P0, value ^ SVG_HASH_P1 );
+}
+
+HB_U64 svg_hash_bytes( HB_U64 hash, const void *data, HB_SIZE len )
+{
+   const unsigned char *p = ( const unsigned char * ) data;
+   HB_U64 value;
+
+   hash = svg_hash_u64( hash, len );
+
+   while( len >= 8 )
+   {
+      memcpy( &value, p, 8 );
+      hash = svg_hash_u64( hash, value );
+      p += 8;
+      len -= 8;
+   }
+
+   if( len )
+   {
+      value = 0;
+      memcpy( &value, p, len );
+      hash = svg_hash_u64( hash, value );
+   }
+
+   return hash;
+}
+
+/* Type and value of an argument; arrays and hashes element by element */
+HB_U64 svg_hash_item( HB_U64 hash, PHB_ITEM pItem )
+{
+   if( pItem == NULL || HB_IS_NIL( pItem ) )
+   {
+      hash = svg_hash_u64( hash, 0 );
+   }
+   else if( HB_IS_NUMERIC( pItem ) )
+   {
+      double value = hb_itemGetND( pItem );
+      HB_U64 bits;
+
+      memcpy( &bits, &value, sizeof( bits ) );
+      hash = svg_hash_u64( svg_hash_u64( hash, 1 ), bits );
+   }
+   else if( HB_IS_STRING( pItem ) )
+   {
+      hash = svg_hash_bytes( svg_hash_u64( hash, 2 ), hb_itemGetCPtr( pItem ), hb_itemGetCLen( pItem ) );
+   }
+   else if( HB_IS_LOGICAL( pItem ) )
+   {
+      hash = svg_hash_u64( svg_hash_u64( hash, 3 ), hb_itemGetL( pItem ) ? 1 : 0 );
+   }
+   else if( HB_IS_HASH( pItem ) )
+   {
+      HB_SIZE len = hb_hashLen( pItem );
+
+      hash = svg_hash_u64( svg_hash_u64( hash, 6 ), len );
+      for( HB_SIZE i = 1; i <= len; ++i )
+      {
+         hash = svg_hash_item( hash, hb_hashGetKeyAt( pItem, i ) );
+         hash = svg_hash_item( hash, hb_hashGetValueAt( pItem, i ) );
+      }
+   }
+   else if( HB_IS_ARRAY( pItem ) )
+   {
+      HB_SIZE len = hb_arrayLen( pItem );
+
+      hash = svg_hash_u64( svg_hash_u64( hash, 4 ), len );
+      for( HB_SIZE i = 1; i <= len; ++i )
+      {
+         hash = svg_hash_item( hash, hb_arrayGetItemPtr( pItem, i ) );
+      }
+   }
+   else
+   {
+      hash = svg_hash_u64( hash, 7 );
+   }
+
+   return hash;
+}
+
+/* Folds the current function and its arguments after the handle into the document hash */
+void svg_cache_call( SVG *svg )
+{
+   char name[ HB_SYMBOL_NAME_LEN + HB_SYMBOL_NAME_LEN + 5 ];
+   int count = hb_pcount();
+
+   hb_procname( 0, name, HB_FALSE );
+   svg->hash = svg_hash_bytes( svg->hash, name, strlen( name ) );
+   svg->hash = svg_hash_u64( svg->hash, ( HB_U64 ) count );
+
+   for( int i = 2; i <= count; ++i )
+   {
+      svg->hash = svg_hash_item( svg->hash, hb_param( i, HB_IT_ANY ) );
+   }
+}
+
+/* 16 hex digits */
+void svg_cache_key( HB_U64 hash, char *key )
+{
+   sprintf( key, "%08x%08x", ( unsigned int ) ( hash >> 32 ), ( unsigned int ) ( hash & 0xFFFFFFFF ) );
+}
+
+void svg_cache_set_dir( const char *dir, HB_SIZE limit )
+{
+   hb_threadEnterCriticalSection( &s_cacheMtx );
+   s_cacheLimit = limit;
+   if( s_cacheDir )
+   {
+      hb_xfree( s_cacheDir );
+      s_cacheDir = NULL;
+   }
+   if( dir && *dir )
+   {
+      s_cacheDir = hb_strdup( dir );
+   }
+   hb_threadLeaveCriticalSection( &s_cacheMtx );
+}
+
+/* Copy of the cache directory, NULL when none is configured, and the memory limit of its documents */
+char *svg_cache_dir( HB_SIZE *limit )
+{
+   char *dir = NULL;
+
+   hb_threadEnterCriticalSection( &s_cacheMtx );
+   if( s_cacheDir )
+   {
+      dir = hb_strdup( s_cacheDir );
+   }
+   *limit = s_cacheLimit;
+   hb_threadLeaveCriticalSection( &s_cacheMtx );
+
+   return dir;
+}
+
+/* A file about to be overwritten may be a link to a cache entry; truncating
+   it would change the entry, so the name is detached first */
+void svg_cache_detach( const char *filename )
+{
+#if defined( HB_OS_UNIX )
+   struct stat st;
+
+   if( stat( filename, &st ) == 0 && S_ISREG( st.st_mode ) && st.st_nlink > 1 )
+   {
+      remove( filename );
+   }
+#else
+   HB_SYMBOL_UNUSED( filename );
+#endif
+}
+
+/* Moves the in-memory output to a temporary file in the cache directory */
+bool svg_cache_spill( SVG *svg, bool force )
+{
+   if( svg->file )
+      return T;
+
+   if( ! force && ( svg->cache_limit == 0 || svg->out.len < svg->cache_limit ) )
+      return F;
+
+   char name[ 64 ];
+   HB_U32 count;
+
+   hb_threadEnterCriticalSection( &s_cacheMtx );
+   count = ++s_tempCount;
+   hb_threadLeaveCriticalSection( &s_cacheMtx );
+
+   sprintf( name, "tmp%lx_%p_%u.svg", ( unsigned long ) time( NULL ), ( void * ) svg, count );
+   svg->tempname = ( char * ) hb_xgrab( strlen( svg->cache ) + strlen( name ) + 2 );
+   svg_cache_path( svg->tempname, svg->cache, name );
+
+   svg->file = fopen( svg->tempname, "wb" );
+   if( svg->file == NULL )
+   {
+      fprintf( stderr, "Error: Could not open file '%s' for writing.\n", svg->tempname );
+      hb_xfree( svg->tempname );
+      svg->tempname = NULL;
+      svg->error = T;
+      return F;
+   }
+
+   setvbuf( svg->file, NULL, _IONBF, 0 );
+   return T;
+}
+
+/* Stores or reuses the cache entry of a finished document and links it to its file name */
+bool svg_cache_close( SVG *svg )
+{
+   char key[ 21 ];   // 16 hex digits and ".svg"
+   char *cached = ( char * ) hb_xgrab( strlen( svg->cache ) + 24 );
+   bool ok = T;
+
+   svg_cache_key( svg->hash, key );
+   strcat( key, ".svg" );
+   svg_cache_path( cached, svg->cache, key );
+
+   if( svg_cache_exists( cached ) )
+   {
+      // Same calls, same document: the output is dropped unwritten
+      svg->out.len = 0;
+      if( svg->file )
+      {
+         fclose( svg->file );
+         remove( svg->tempname );
+      }
+   }
+   else
+   {
+      if( svg_cache_spill( svg, T ) )
+      {
+         if( svg->out.len && fwrite( svg->out.data, 1, svg->out.len, svg->file ) != svg->out.len )
+         {
+            svg->error = T;
+         }
+         svg->out.len = 0;
+
+         if( fclose( svg->file ) != 0 )
+         {
+            svg->error = T;
+         }
+
+         if( svg->error || rename( svg->tempname, cached ) != 0 )
+         {
+            remove( svg->tempname );
+            ok = F;
+         }
+      }
+      else
+      {
+         ok = F;
+      }
+   }
+   svg->file = NULL;
+
+   if( ok && ! svg_cache_publish( cached, svg->filename ) )
+   {
+      ok = F;
+   }
+
+   if( svg->tempname )
+   {
+      hb_xfree( svg->tempname );
+      svg->tempname = NULL;
+   }
+   hb_xfree( svg->cache );
+   svg->cache = NULL;
+   hb_xfree( cached );
+
+   return ok;
+}
@@ -0,0 +1,138 @@
+/*
+ * Harbour Scalable Vector Graphics (HBSVG) Project
+ * Copyright 2014 - 2024 Rafał Jopek
+ * Website: https://harbour.pl
+ *
+ */
+
+/*
+ * Downsampling of long series to a point budget.
+ *
+ * Both methods select a subset of the input points, in input order, in one
+ * linear pass:
+ *
+ *    LTTB      Largest-Triangle-Three-Buckets (Sveinn Steinarsson, 2013).
+ *              Keeps the first and the last point and, from every bucket
+ *              in between, the point forming the largest triangle with the
+ *              point kept before it and the average of the next bucket.
+ *    min/max   Keeps the lowest and the highest point of every bucket, so
+ *              no peak is lost; two points per bucket.
+ */
+
+#include "hbsvg.h"
+
+/* ------------------------------------------------------------------------- */
+/* Selects at most threshold of count points ( x, y pairs ); the indices go
+   to selected, which must have room for threshold entries. Returns how many
+   were selected. */
+HB_SIZE svg_downsample_lttb( const double *points, HB_SIZE count, HB_SIZE threshold, HB_SIZE *selected )
+{
+   HB_SIZE n = 0;
+
+   if( threshold >= count || threshold < 3 )
+   {
+      HB_SIZE limit = threshold < count ? threshold : count;
+
+      for( HB_SIZE i = 0; i < limit; ++i )
+      {
+         selected[ n++ ] = i * ( count - 1 ) / ( limit > 1 ? limit - 1 : 1 );
+      }
+      return n;
+   }
+
+   // Buckets of the points between the first and the last one
+   double every = ( double ) ( count - 2 ) / ( threshold - 2 );
+   HB_SIZE a = 0;
+
+   selected[ n++ ] = 0;
+
+   for( HB_SIZE i = 0; i < threshold - 2; ++i )
+   {
+      HB_SIZE avg_start = ( HB_SIZE ) ( ( i + 1 ) * every ) + 1;
+      HB_SIZE avg_end = ( HB_SIZE ) ( ( i + 2 ) * every ) + 1;
+      double avg_x = 0, avg_y = 0;
+
+      if( avg_end > count )
+         avg_end = count;
+
+      for( HB_SIZE j = avg_start; j < avg_end; ++j )
+      {
+         avg_x += points[ j * 2 ];
+         avg_y += points[ j * 2 + 1 ];
+      }
+      if( avg_end > avg_start )
+      {
+         avg_x /= ( double ) ( avg_end - avg_start );
+         avg_y /= ( double ) ( avg_end - avg_start );
+      }
+      else
+      {
+         avg_x = points[ ( count - 1 ) * 2 ];
+         avg_y = points[ ( count - 1 ) * 2 + 1 ];
+      }
+
+      HB_SIZE start = ( HB_SIZE ) ( i * every ) + 1;
+      HB_SIZE end = ( HB_SIZE ) ( ( i + 1 ) * every ) + 1;
+      double ax = points[ a * 2 ];
+      double ay = points[ a * 2 + 1 ];
+      double max_area = -1;
+      HB_SIZE next = start;
+
+      for( HB_SIZE j = start; j < end; ++j )
+      {
+         // Twice the triangle area, the factor does not change the choice
+         double area = fabs( ( ax - avg_x ) * ( points[ j * 2 + 1 ] - ay ) - ( ax - points[ j * 2 ] ) * ( avg_y - ay ) );
+
+         if( area > max_area )
+         {
+            max_area = area;
+            next = j;
+         }
+      }
+
+      selected[ n++ ] = next;
+      a = next;
+   }
+
+   selected[ n++ ] = count - 1;
+
+   return n;
+}
+
+/* Same contract as svg_downsample_lttb(), threshold / 2 buckets */
+HB_SIZE svg_downsample_minmax( const double *points, HB_SIZE count, HB_SIZE threshold, HB_SIZE *selected )
+{
+   HB_SIZE buckets = threshold / 2;
+   HB_SIZE n = 0;
+
+   if( threshold >= count || buckets == 0 )
+   {
+      return svg_downsample_lttb( points, count, threshold, selected );
+   }
+
+   for( HB_SIZE b = 0; b < buckets; ++b )
+   {
+      HB_SIZE start = b * count / buckets;
+      HB_SIZE end = ( b + 1 ) * count / buckets;
+      HB_SIZE lo = start, hi = start;
+
+      for( HB_SIZE j = start + 1; j < end; ++j )
+      {
+         if( points[ j * 2 + 1 ] < points[ lo * 2 + 1 ] ) lo = j;
+         if( points[ j * 2 + 1 ] > points[ hi * 2 + 1 ] ) hi = j;
+      }
+
+      // Kept in input order
+      if( lo == hi )
+      {
+         selected[ n++ ] = lo;
+      }
+      else
+      {
+         selected[ n++ ] = lo < hi ? lo : hi;
+         selected[ n++ ] = lo < hi ? hi : lo;
+      }
+   }
+
+   return n;
+}
@@ -0,0 +1,377 @@
+/*
+ * Harbour Scalable Vector Graphics (HBSVG) Project
+ * Copyright 2014 - 2024 Rafał Jopek
+ * Website: https://harbour.pl
+ *
+ */
+
+/*
+ * Piecewise cubic Bezier fitting of sampled points.
+ *
+ * Philip J. Schneider, "An Algorithm for Automatically Fitting Digitized
+ * Curves", Graphics Gems, 1990. The samples are first split at corners,
+ * then every run is fitted with a least-squares cubic whose end tangents
+ * are fixed. A fit that misses the tolerance is improved by a few rounds
+ * of Newton-Raphson reparameterization and, failing that, split at the
+ * point of maximum error. Splits are kept on an explicit stack, so long
+ * inputs cannot exhaust the C stack.
+ */
+
+#include "hbsvg.h"
+
+#define SVG_FIT_ITERATIONS  4
+
+typedef struct
+{
+   double x;
+   double y;
+} SVG_VEC;
+
+typedef struct
+{
+   HB_SIZE first;
+   HB_SIZE last;
+   SVG_VEC tangent1;
+   SVG_VEC tangent2;
+} SVG_FIT_RUN;
+
+/* ------------------------------------------------------------------------- */
+// static
+static SVG_VEC svg_vec( double x, double y )
+{
+   SVG_VEC v;
+
+   v.x = x;
+   v.y = y;
+   return v;
+}
+
+static SVG_VEC svg_vec_sub( SVG_VEC a, SVG_VEC b )
+{
+   return svg_vec( a.x - b.x, a.y - b.y );
+}
+
+static SVG_VEC svg_vec_add( SVG_VEC a, SVG_VEC b )
+{
+   return svg_vec( a.x + b.x, a.y + b.y );
+}
+
+static SVG_VEC svg_vec_scale( SVG_VEC a, double s )
+{
+   return svg_vec( a.x * s, a.y * s );
+}
+
+static double svg_vec_dot( SVG_VEC a, SVG_VEC b )
+{
+   return a.x * b.x + a.y * b.y;
+}
+
+static double svg_vec_len( SVG_VEC a )
+{
+   return sqrt( a.x * a.x + a.y * a.y );
+}
+
+static SVG_VEC svg_vec_norm( SVG_VEC a )
+{
+   double len = svg_vec_len( a );
+
+   return len > 0 ? svg_vec_scale( a, 1 / len ) : a;
+}
+
+static SVG_VEC svg_bezier_point( const SVG_VEC *bez, int degree, double t )
+{
+   SVG_VEC tmp[ 4 ];
+
+   for( int i = 0; i <= degree; ++i )
+   {
+      tmp[ i ] = bez[ i ];
+   }
+
+   // de Casteljau
+   for( int i = 1; i <= degree; ++i )
+   {
+      for( int j = 0; j <= degree - i; ++j )
+      {
+         tmp[ j ] = svg_vec_add( svg_vec_scale( tmp[ j ], 1 - t ), svg_vec_scale( tmp[ j + 1 ], t ) );
+      }
+   }
+
+   return tmp[ 0 ];
+}
+
+/* Least-squares cubic through the run with the given end tangents */
+static void svg_fit_generate( const SVG_VEC *d, HB_SIZE first, HB_SIZE last, const double *u, SVG_VEC t1, SVG_VEC t2, SVG_VEC *bez )
+{
+   double c00 = 0, c01 = 0, c11 = 0, x0 = 0, x1 = 0;
+   SVG_VEC p0 = d[ first ];
+   SVG_VEC p3 = d[ last ];
+
+   for( HB_SIZE i = 0; i <= last - first; ++i )
+   {
+      double t = u[ i ];
+      double mt = 1 - t;
+      double b0 = mt * mt * mt;
+      double b1 = 3 * t * mt * mt;
+      double b2 = 3 * t * t * mt;
+      double b3 = t * t * t;
+      SVG_VEC a1 = svg_vec_scale( t1, b1 );
+      SVG_VEC a2 = svg_vec_scale( t2, b2 );
+      SVG_VEC tmp = svg_vec_sub( d[ first + i ], svg_vec_add( svg_vec_scale( p0, b0 + b1 ), svg_vec_scale( p3, b2 + b3 ) ) );
+
+      c00 += svg_vec_dot( a1, a1 );
+      c01 += svg_vec_dot( a1, a2 );
+      c11 += svg_vec_dot( a2, a2 );
+      x0 += svg_vec_dot( a1, tmp );
+      x1 += svg_vec_dot( a2, tmp );
+   }
+
+   double det = c00 * c11 - c01 * c01;
+   double alpha1 = 0, alpha2 = 0;
+   double seg = svg_vec_len( svg_vec_sub( p3, p0 ) );
+   double eps = 1.0e-6 * seg;
+
+   if( fabs( det ) > 1.0e-12 )
+   {
+      alpha1 = ( x0 * c11 - x1 * c01 ) / det;
+      alpha2 = ( c00 * x1 - c01 * x0 ) / det;
+   }
+
+   // Degenerate system or control points behind the ends: fall back to the Wu/Barsky heuristic
+   if( alpha1 < eps || alpha2 < eps )
+   {
+      alpha1 = alpha2 = seg / 3;
+   }
+
+   bez[ 0 ] = p0;
+   bez[ 1 ] = svg_vec_add( p0, svg_vec_scale( t1, alpha1 ) );
+   bez[ 2 ] = svg_vec_add( p3, svg_vec_scale( t2, alpha2 ) );
+   bez[ 3 ] = p3;
+}
+
+/* Largest squared distance between the samples and the curve */
+static double svg_fit_error( const SVG_VEC *d, HB_SIZE first, HB_SIZE last, const SVG_VEC *bez, const double *u, HB_SIZE *split )
+{
+   double max = 0;
+
+   *split = ( first + last ) / 2;
+
+   for( HB_SIZE i = first + 1; i < last; ++i )
+   {
+      SVG_VEC v = svg_vec_sub( svg_bezier_point( bez, 3, u[ i - first ] ), d[ i ] );
+      double dist = svg_vec_dot( v, v );
+
+      if( dist >= max )
+      {
+         max = dist;
+         *split = i;
+      }
+   }
+
+   return max;
+}
+
+/* One Newton-Raphson step towards the parameter of the closest curve point */
+static void svg_fit_reparameterize( const SVG_VEC *d, HB_SIZE first, HB_SIZE last, double *u, const SVG_VEC *bez )
+{
+   SVG_VEC q1[ 3 ], q2[ 2 ];
+
+   for( int i = 0; i < 3; ++i )
+   {
+      q1[ i ] = svg_vec_scale( svg_vec_sub( bez[ i + 1 ], bez[ i ] ), 3 );
+   }
+   for( int i = 0; i < 2; ++i )
+   {
+      q2[ i ] = svg_vec_scale( svg_vec_sub( q1[ i + 1 ], q1[ i ] ), 2 );
+   }
+
+   for( HB_SIZE i = 0; i <= last - first; ++i )
+   {
+      double t = u[ i ];
+      SVG_VEC diff = svg_vec_sub( svg_bezier_point( bez, 3, t ), d[ first + i ] );
+      SVG_VEC d1 = svg_bezier_point( q1, 2, t );
+      SVG_VEC d2 = svg_bezier_point( q2, 1, t );
+      double numerator = svg_vec_dot( diff, d1 );
+      double denominator = svg_vec_dot( d1, d1 ) + svg_vec_dot( diff, d2 );
+
+      if( denominator != 0 )
+      {
+         t -= numerator / denominator;
+         u[ i ] = t < 0 ? 0 : ( t > 1 ? 1 : t );
+      }
+   }
+}
+
+static void svg_fit_emit( SVG_BUFFER *out, const SVG_VEC *bez )
+{
+   double seg[ 6 ];
+
+   seg[ 0 ] = bez[ 1 ].x;
+   seg[ 1 ] = bez[ 1 ].y;
+   seg[ 2 ] = bez[ 2 ].x;
+   seg[ 3 ] = bez[ 2 ].y;
+   seg[ 4 ] = bez[ 3 ].x;
+   seg[ 5 ] = bez[ 3 ].y;
+
+   svg_buffer_append( out, ( const char * ) seg, sizeof( seg ) );
+}
+
+/* ------------------------------------------------------------------------- */
+/* Fits cubic Bezier segments to count points ( x, y pairs ) within tolerance
+   units. Consecutive duplicates are ignored; turns sharper than corner_angle
+   degrees become corners. Returns the number of segments; *segments holds
+   c1x, c1y, c2x, c2y, x, y for each of them and starts at the first point.
+   It must be released with hb_xfree() when not NULL. */
+HB_SIZE svg_fit_curve( const double *points, HB_SIZE count, double tolerance, double corner_angle, double **segments )
+{
+   SVG_BUFFER out;
+   HB_SIZE n = 0;
+
+   memset( &out, 0, sizeof( SVG_BUFFER ) );
+   *segments = NULL;
+
+   if( count < 2 )
+      return 0;
+
+   SVG_VEC *d = ( SVG_VEC * ) hb_xgrab( count * sizeof( SVG_VEC ) );
+
+   for( HB_SIZE i = 0; i < count; ++i )
+   {
+      SVG_VEC p = svg_vec( points[ i * 2 ], points[ i * 2 + 1 ] );
+
+      if( n == 0 || p.x != d[ n - 1 ].x || p.y != d[ n - 1 ].y )
+      {
+         d[ n++ ] = p;
+      }
+   }
+
+   if( n < 2 )
+   {
+      hb_xfree( d );
+      return 0;
+   }
+
+   double error = tolerance * tolerance;
+   double corner_cos = cos( corner_angle * M_PI / 180.0 );
+   double *u = ( double * ) hb_xgrab( n * sizeof( double ) );
+   SVG_FIT_RUN *stack = NULL;
+   HB_SIZE stack_size = 0, stack_capacity = 0;
+   HB_SIZE first = 0;
+
+   while( first < n - 1 )
+   {
+      // The run ends at the next corner
+      HB_SIZE last = first + 1;
+
+      while( last < n - 1 )
+      {
+         SVG_VEC in = svg_vec_norm( svg_vec_sub( d[ last ], d[ last - 1 ] ) );
+         SVG_VEC out_dir = svg_vec_norm( svg_vec_sub( d[ last + 1 ], d[ last ] ) );
+
+         if( svg_vec_dot( in, out_dir ) < corner_cos )
+            break;
+         last++;
+      }
+
+      SVG_FIT_RUN run;
+
+      run.first = first;
+      run.last = last;
+      run.tangent1 = svg_vec_norm( svg_vec_sub( d[ first + 1 ], d[ first ] ) );
+      run.tangent2 = svg_vec_norm( svg_vec_sub( d[ last - 1 ], d[ last ] ) );
+
+      stack_size = 0;
+      for( ;; )
+      {
+         HB_SIZE a = run.first;
+         HB_SIZE b = run.last;
+         SVG_VEC bez[ 4 ];
+
+         if( b - a == 1 )
+         {
+            double dist = svg_vec_len( svg_vec_sub( d[ b ], d[ a ] ) ) / 3;
+
+            bez[ 0 ] = d[ a ];
+            bez[ 1 ] = svg_vec_add( d[ a ], svg_vec_scale( run.tangent1, dist ) );
+            bez[ 2 ] = svg_vec_add( d[ b ], svg_vec_scale( run.tangent2, dist ) );
+            bez[ 3 ] = d[ b ];
+            svg_fit_emit( &out, bez );
+         }
+         else
+         {
+            HB_SIZE split;
+            double max;
+
+            // Chord-length parameterization
+            u[ 0 ] = 0;
+            for( HB_SIZE i = a + 1; i <= b; ++i )
+            {
+               u[ i - a ] = u[ i - a - 1 ] + svg_vec_len( svg_vec_sub( d[ i ], d[ i - 1 ] ) );
+            }
+            for( HB_SIZE i = a + 1; i <= b; ++i )
+            {
+               u[ i - a ] /= u[ b - a ];
+            }
+
+            svg_fit_generate( d, a, b, u, run.tangent1, run.tangent2, bez );
+            max = svg_fit_error( d, a, b, bez, u, &split );
+
+            if( max >= error && max < error * 4 )
+            {
+               for( int i = 0; i < SVG_FIT_ITERATIONS && max >= error; ++i )
+               {
+                  svg_fit_reparameterize( d, a, b, u, bez );
+                  svg_fit_generate( d, a, b, u, run.tangent1, run.tangent2, bez );
+                  max = svg_fit_error( d, a, b, bez, u, &split );
+               }
+            }
+
+            if( max < error )
+            {
+               svg_fit_emit( &out, bez );
+            }
+            else
+            {
+               // Split at the worst point; the right half waits on the stack
+               SVG_VEC center = svg_vec_norm( svg_vec_sub( d[ split - 1 ], d[ split + 1 ] ) );
+
+               if( center.x == 0 && center.y == 0 )
+               {
+                  center = svg_vec_norm( svg_vec( d[ split ].y - d[ split - 1 ].y, d[ split - 1 ].x - d[ split ].x ) );
+               }
+
+               if( stack_size == stack_capacity )
+               {
+                  stack_capacity = stack_capacity ? stack_capacity * 2 : 32;
+                  stack = ( SVG_FIT_RUN * ) hb_xrealloc( stack, stack_capacity * sizeof( SVG_FIT_RUN ) );
+               }
+
+               stack[ stack_size ].first = split;
+               stack[ stack_size ].last = b;
+               stack[ stack_size ].tangent1 = svg_vec_scale( center, -1 );
+               stack[ stack_size ].tangent2 = run.tangent2;
+               stack_size++;
+
+               run.last = split;
+               run.tangent2 = center;
+               continue;
+            }
+         }
+
+         if( stack_size == 0 )
+            break;
+         run = stack[ --stack_size ];
+      }
+
+      first = last;
+   }
+
+   if( stack )
+   {
+      hb_xfree( stack );
+   }
+   hb_xfree( u );
+   hb_xfree( d );
+
+   *segments = ( double * ) out.data;
+   return out.len / ( 6 * sizeof( double ) );
+}
@@ -0,0 +1,395 @@
+/*
+ * Harbour Scalable Vector Graphics (HBSVG) Project
+ * Copyright 2014 - 2024 Rafał Jopek
+ * Website: https://harbour.pl
+ *
+ */
+
+/*
+ * Font metrics for text measurement.
+ *
+ * Glyph advances of the PDF core fonts Helvetica, Times and Courier, in
+ * 1/1000 em, are compiled in. Arial, Times New Roman and Courier New, as well
+ * as the Liberation, Croscore and Nimbus families, share these advances, so
+ * they cover the common web-safe fonts; other families are measured as
+ * Helvetica. Weights of 600 and more use the bold tables.
+ *
+ * Text is UTF-8. ASCII indexes the tables directly, accented Latin letters up
+ * to U+017F take the advance of their base letter, combining marks nothing
+ * and East Asian wide characters one em. Pairs are kerned by glyph class, the
+ * classes group the kerning pairs of the fonts' metric files.
+ */
+
+#include "hbsvg.h"
+
+#define SVG_TEXT_CACHE_SIZE  256   // entries, direct-mapped
+#define SVG_TEXT_CACHE_LEN   46    // longer strings are measured every time
+#define SVG_MONO_ADVANCE     600   // every Courier glyph
+#define SVG_WIDE_ADVANCE     1000  // East Asian wide characters
+
+enum
+{
+   SVG_FACE_SANS,
+   SVG_FACE_SANS_BOLD,
+   SVG_FACE_SERIF,
+   SVG_FACE_SERIF_BOLD,
+   SVG_FACE_MONO
+};
+
+/* Helvetica ( Arial ), U+0020 .. U+007E */
+static const HB_U16 s_helvetica[ 95 ] =
+{
+    278,  278,  355,  556,  556,  889,  667,  191,  333,  333,  389,  584,  278,  333,  278,  278,
+    556,  556,  556,  556,  556,  556,  556,  556,  556,  556,  278,  278,  584,  584,  584,  556,
+   1015,  667,  667,  722,  722,  667,  611,  778,  722,  278,  500,  667,  556,  833,  722,  778,
+    667,  778,  722,  667,  611,  722,  667,  944,  667,  667,  611,  278,  278,  278,  469,  556,
+    333,  556,  556,  500,  556,  556,  278,  556,  556,  222,  222,  500,  222,  833,  556,  556,
+    556,  556,  333,  500,  278,  556,  500,  722,  500,  500,  500,  334,  260,  334,  584
+};
+
+/* Helvetica Bold ( Arial Bold ), U+0020 .. U+007E */
+static const HB_U16 s_helvetica_bold[ 95 ] =
+{
+    278,  333,  474,  556,  556,  889,  722,  238,  333,  333,  389,  584,  278,  333,  278,  278,
+    556,  556,  556,  556,  556,  556,  556,  556,  556,  556,  333,  333,  584,  584,  584,  611,
+    975,  722,  722,  722,  722,  667,  611,  778,  722,  278,  556,  722,  611,  833,  722,  778,
+    667,  778,  722,  667,  611,  722,  667,  944,  667,  667,  611,  333,  278,  333,  584,  556,
+    333,  556,  611,  556,  611,  556,  333,  611,  611,  278,  278,  556,  278,  889,  611,  611,
+    611,  611,  389,  556,  333,  611,  556,  778,  556,  556,  500,  389,  280,  389,  584
+};
+
+/* Times ( Times New Roman ), U+0020 .. U+007E */
+static const HB_U16 s_times[ 95 ] =
+{
+    250,  333,  408,  500,  500,  833,  778,  180,  333,  333,  500,  564,  250,  333,  250,  278,
+    500,  500,  500,  500,  500,  500,  500,  500,  500,  500,  278,  278,  564,  564,  564,  444,
+    921,  722,  667,  667,  722,  611,  556,  722,  722,  333,  389,  722,  611,  889,  722,  722,
+    556,  722,  667,  556,  611,  722,  722,  944,  722,  722,  611,  333,  278,  333,  469,  500,
+    333,  444,  500,  444,  500,  444,  333,  500,  500,  278,  278,  500,  278,  778,  500,  500,
+    500,  500,  333,  389,  278,  500,  500,  722,  500,  500,  444,  480,  200,  480,  541
+};
+
+/* Times Bold ( Times New Roman Bold ), U+0020 .. U+007E */
+static const HB_U16 s_times_bold[ 95 ] =
+{
+    250,  333,  555,  500,  500, 1000,  833,  278,  333,  333,  500,  570,  250,  333,  250,  278,
+    500,  500,  500,  500,  500,  500,  500,  500,  500,  500,  333,  333,  570,  570,  570,  500,
+    930,  722,  667,  722,  722,  667,  611,  778,  778,  389,  500,  778,  667,  944,  722,  778,
+    611,  778,  722,  556,  667,  722,  722, 1000,  722,  722,  667,  333,  278,  333,  581,  500,
+    333,  500,  556,  444,  556,  444,  333,  500,  556,  278,  333,  556,  278,  833,  556,  500,
+    556,  556,  444,  389,  333,  556,  500,  722,  500,  500,  444,  394,  220,  394,  520
+};
+
+/* Latin-1 Supplement and Latin Extended-A, U+00A0 .. U+017F: the ASCII glyph
+   of the same advance ( the base letter for accented ones ) */
+static const char s_latin[] =
+   " !0000|0`Or0+-O`*+```u0.``r0%%%?"
+   "AAAAAAWCEEEEIIIIDNOOOOO+OUUUUYPh"
+   "aaaaaamceeeeiiiionooooo+ouuuuypy"
+   "AaAaAaCcCcCcCcDdDdEeEeEeEeEeGgGg"
+   "GgGgHhHhIiIiIiIiIiOoJjKkkLlLlLlL"
+   "lLlNnNnNnnNnOoOoOoWmRrRrRrSsSsSs"
+   "SsTtTtTtUuUuUuUuUuUuWwYyYZzZzZzf";
+
+/* Kerning class of the left glyph of a pair, U+0020 .. U+007E */
+static const HB_BYTE s_kern_left[ 95 ] =
+{
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  1,  0,  0,  9,  0,  2,  0,  0,  0,  0, 11,  3,  0,  0,  9,
+    4,  9, 10,  0,  5,  0,  6,  7,  0,  8,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, 14,  0,
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  0, 12,  0,  0,  0, 13, 13,  0, 13,  0,  0,  0,  0,  0
+};
+
+/* Kerning class of the right glyph */
+static const HB_BYTE s_kern_right[ 95 ] =
+{
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, 12, 13, 12,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+    0,  0, 14, 14,  0,  0,  0,  0,  0,  1,  0,  2,  0,  0,  0,  2,  0,  0,  0,  0,  0,  0,  0,  2,
+    0,  2,  0,  0,  3,  4,  5,  6, 15,  7,  0,  0,  0,  0,  0,  0,  0,  8,  0,  9,  0,  9,  0,  0,
+    0, 16,  0,  0,  0,  0,  0,  9,  0,  0, 10,  0,  0, 10, 11, 11,  0, 11,  0,  0,  0,  0,  0
+};
+
+/* Kerning in 1/1000 em by left and right class, Helvetica */
+static const HB_I16 s_kern_sans[ 15 ][ 17 ] =
+{
+   {    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0 },
+   {    0,    0,  -30, -120,  -50,  -70,  -50, -100,    0,    0,  -30,  -40,    0,    0,    0,    0,    0 },   // A
+   {    0,  -80,    0,    0,    0,    0,    0,    0,  -50,  -30,  -45,    0, -150,    0,    0,    0,    0 },   // F
+   {    0,    0,    0, -110,    0, -110,  -70, -140,    0,    0,    0,  -30,    0,    0,    0,    0,    0 },   // L
+   {    0, -120,    0,    0,    0,    0,    0,    0,  -40,  -50,    0,    0, -180,    0,    0,    0,    0 },   // P
+   {    0, -120,  -40,    0,    0,    0,    0,    0, -120, -120, -120, -120, -120, -140,  -20,    0,    0 },   // T
+   {    0,  -80,  -40,    0,    0,    0,    0,    0,  -70,  -80,  -70,    0, -125,  -80,  -40,    0,    0 },   // V
+   {    0,  -50,  -20,    0,    0,    0,    0,    0,  -40,  -30,  -30,  -20,  -80,  -40,    0,    0,    0 },   // W
+   {    0, -110,  -85,    0,    0,    0,    0,    0, -140, -140, -110, -110, -140, -140,  -60,    0,  -20 },   // Y
+   {    0,  -30,    0,  -40,    0,  -60,  -35,  -80,    0,    0,    0,    0,  -50,    0,    0,  -50,    0 },   // DOQ
+   {    0,    0,  -20,  -30,  -40,  -50,  -30,  -50,    0,    0,    0,    0,    0,    0,    0,    0,    0 },   // R
+   {    0,    0,  -50,    0,    0,    0,    0,    0,    0,  -40,  -30,  -50,    0,    0,    0,    0,    0 },   // K
+   {    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,  -50,    0,    0,    0,    0 },   // r
+   {    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,  -80,    0,    0,    0,    0 },   // vwy
+   {    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,  -30,    0,    0,    0,    0 }    // f
+};
+
+/* Times */
+static const HB_I16 s_kern_serif[ 15 ][ 17 ] =
+{
+   {    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0 },
+   {    0,    0,  -45, -111,  -55, -135,  -90, -105,    0,    0,    0,  -85,    0,    0,    0,    0,    0 },   // A
+   {    0,  -74,    0,    0,    0,    0,    0,    0,  -15,    0,    0,    0,  -80,    0,    0,    0,    0 },   // F
+   {    0,    0,    0,  -92,    0, -100,  -74, -100,    0,    0,    0,  -55,    0,    0,    0,    0,    0 },   // L
+   {    0,  -92,    0,    0,    0,    0,    0,    0,  -15,    0,    0,    0, -111,    0,    0,    0,    0 },   // P
+   {    0,  -93,  -18,    0,    0,    0,    0,    0,  -80,  -75,  -40,  -80,  -74,  -92,  -50,    0,    0 },   // T
+   {    0, -135,  -40,    0,    0,    0,    0,    0, -111, -120,  -75,    0, -129, -100,  -74,    0,    0 },   // V
+   {    0, -120,  -10,    0,    0,    0,    0,    0,  -80,  -80,  -30,  -73,  -92,  -65,  -37,    0,    0 },   // W
+   {    0, -120,  -30,    0,    0,    0,    0,    0, -100, -105, -111,    0, -129, -111,  -92,    0,  -55 },   // Y
+   {    0,  -40,    0,  -40,    0,  -50,  -35,  -50,    0,    0,    0,    0,    0,    0,    0,  -40,    0 },   // DOQ
+   {    0,    0,  -40,  -60,  -40,  -80,  -55,  -65,    0,    0,    0,    0,    0,    0,    0,    0,    0 },   // R
+   {    0,    0,  -30,    0,    0,    0,    0,    0,    0,  -25,  -15,  -25,    0,    0,    0,    0,    0 },   // K
+   {    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,  -50,    0,    0,    0,    0 },   // r
+   {    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,  -65,    0,    0,    0,    0 },   // vwy
+   {    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0 }    // f
+};
+
+
+typedef struct
+{
+   const HB_U16 *advance;           // NULL: monospaced, SVG_MONO_ADVANCE
+   const HB_I16 ( *kern )[ 17 ];    // NULL: not kerned
+} SVG_FACE;
+
+static const SVG_FACE s_faces[] =
+{
+   { s_helvetica,      s_kern_sans  },
+   { s_helvetica_bold, s_kern_sans  },
+   { s_times,          s_kern_serif },
+   { s_times_bold,     s_kern_serif },
+   { NULL,             NULL         }
+};
+
+typedef struct
+{
+   const char *name;
+   int face;
+} SVG_FAMILY;
+
+static const SVG_FAMILY s_families[] =
+{
+   { "arial",            SVG_FACE_SANS  },
+   { "helvetica",        SVG_FACE_SANS  },
+   { "helvetica neue",   SVG_FACE_SANS  },
+   { "liberation sans",  SVG_FACE_SANS  },
+   { "arimo",            SVG_FACE_SANS  },
+   { "nimbus sans",      SVG_FACE_SANS  },
+   { "sans-serif",       SVG_FACE_SANS  },
+   { "times new roman",  SVG_FACE_SERIF },
+   { "times",            SVG_FACE_SERIF },
+   { "liberation serif", SVG_FACE_SERIF },
+   { "tinos",            SVG_FACE_SERIF },
+   { "nimbus roman",     SVG_FACE_SERIF },
+   { "serif",            SVG_FACE_SERIF },
+   { "courier new",      SVG_FACE_MONO  },
+   { "courier",          SVG_FACE_MONO  },
+   { "liberation mono",  SVG_FACE_MONO  },
+   { "cousine",          SVG_FACE_MONO  },
+   { "nimbus mono ps",   SVG_FACE_MONO  },
+   { "monospace",        SVG_FACE_MONO  }
+};
+
+typedef struct
+{
+   HB_U64 hash;
+   HB_U32 units;
+   HB_BYTE face;
+   HB_BYTE len;
+   char text[ SVG_TEXT_CACHE_LEN ];
+} SVG_TEXT_ENTRY;
+
+struct _SVG_TEXT_CACHE
+{
+   SVG_TEXT_ENTRY entries[ SVG_TEXT_CACHE_SIZE ];
+};
+
+/* ------------------------------------------------------------------------- */
+// static
+/* Advance of a character outside the tables */
+static int svg_font_other( const SVG_FACE *face, HB_U32 cp )
+{
+   if( cp < 0xA0 || ( cp >= 0x0300 && cp < 0x0370 ) || ( cp >= 0x200B && cp < 0x2010 ) || cp == 0xFEFF )
+   {
+      // Control characters, combining marks, zero width spaces and joiners
+      return 0;
+   }
+
+   if( ( cp >= 0x1100 && cp < 0x1160 ) || ( cp >= 0x2E80 && cp < 0xA4D0 ) || ( cp >= 0xAC00 && cp < 0xD7A4 ) ||
+       ( cp >= 0xF900 && cp < 0xFB00 ) || ( cp >= 0xFF00 && cp < 0xFF61 ) || ( cp >= 0xFFE0 && cp < 0xFFE7 ) || cp >= 0x20000 )
+   {
+      return SVG_WIDE_ADVANCE;
+   }
+
+   // Other scripts: an average lowercase letter
+   return face->advance ? face->advance[ 'n' - 0x20 ] : SVG_MONO_ADVANCE;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Face of the first known family in a CSS font-family list */
+int svg_font_face( const char *family, int weight )
+{
+   const char *p = family ? family : "";
+
+   while( *p )
+   {
+      const char *end;
+
+      while( *p == ' ' || *p == ',' || *p == '"' || *p == '\'' )
+      {
+         p++;
+      }
+      end = p;
+      while( *end && *end != ',' )
+      {
+         end++;
+      }
+
+      HB_SIZE len = end - p;
+
+      while( len && ( p[ len - 1 ] == ' ' || p[ len - 1 ] == '"' || p[ len - 1 ] == '\'' ) )
+      {
+         len--;
+      }
+
+      for( HB_SIZE i = 0; i < HB_SIZEOFARRAY( s_families ); ++i )
+      {
+         if( strlen( s_families[ i ].name ) == len && hb_strnicmp( s_families[ i ].name, p, len ) == 0 )
+         {
+            int face = s_families[ i ].face;
+
+            return ( weight >= 600 && face != SVG_FACE_MONO ) ? face + 1 : face;
+         }
+      }
+
+      p = end;
+   }
+
+   return weight >= 600 ? SVG_FACE_SANS_BOLD : SVG_FACE_SANS;
+}
+
+/* Advance width of UTF-8 text in 1/1000 em */
+HB_U32 svg_font_units( int face, const char *text, HB_SIZE len )
+{
+   const SVG_FACE *metrics = &s_faces[ face ];
+   const HB_BYTE *p = ( const HB_BYTE * ) text;
+   const HB_BYTE *end = p + len;
+   HB_I64 units = 0;
+   int left = 0;     // kerning class of the previous glyph
+
+   while( p < end )
+   {
+      HB_U32 cp = *p++;
+
+      if( cp >= 0x80 )
+      {
+         if( cp >= 0xC2 && cp < 0xE0 && p < end && ( p[ 0 ] & 0xC0 ) == 0x80 )
+         {
+            cp = ( ( cp & 0x1F ) << 6 ) | ( p[ 0 ] & 0x3F );
+            p += 1;
+         }
+         else if( cp >= 0xE0 && cp < 0xF0 && end - p >= 2 && ( p[ 0 ] & 0xC0 ) == 0x80 && ( p[ 1 ] & 0xC0 ) == 0x80 )
+         {
+            cp = ( ( cp & 0x0F ) << 12 ) | ( ( HB_U32 ) ( p[ 0 ] & 0x3F ) << 6 ) | ( p[ 1 ] & 0x3F );
+            p += 2;
+         }
+         else if( cp >= 0xF0 && cp < 0xF5 && end - p >= 3 && ( p[ 0 ] & 0xC0 ) == 0x80 && ( p[ 1 ] & 0xC0 ) == 0x80 && ( p[ 2 ] & 0xC0 ) == 0x80 )
+         {
+            cp = ( ( cp & 0x07 ) << 18 ) | ( ( HB_U32 ) ( p[ 0 ] & 0x3F ) << 12 ) | ( ( HB_U32 ) ( p[ 1 ] & 0x3F ) << 6 ) | ( p[ 2 ] & 0x3F );
+            p += 3;
+         }
+         else
+         {
+            // A stray byte is shown as one replacement character
+            cp = 0xFFFD;
+         }
+      }
+
+      int glyph = -1;
+
+      if( cp >= 0x20 && cp < 0x7F )
+      {
+         glyph = cp - 0x20;
+      }
+      else if( cp >= 0xA0 && cp < 0x180 )
+      {
+         glyph = s_latin[ cp - 0xA0 ] - 0x20;
+      }
+
+      if( glyph >= 0 )
+      {
+         units += metrics->advance ? metrics->advance[ glyph ] : SVG_MONO_ADVANCE;
+         if( metrics->kern )
+         {
+            units += metrics->kern[ left ][ s_kern_right[ glyph ] ];
+            left = s_kern_left[ glyph ];
+         }
+      }
+      else
+      {
+         units += svg_font_other( metrics, cp );
+         left = 0;
+      }
+   }
+
+   return units > 0 ? ( HB_U32 ) units : 0;
+}
+
+/* Width of text in user units. Strings measured on a handle are kept in its
+   cache, svg may be NULL. */
+double svg_text_measure( SVG *svg, const char *text, const char *font, int size, int weight )
+{
+   HB_SIZE len = text ? strlen( text ) : 0;
+   int face = svg_font_face( font, weight );
+   HB_U32 units;
+
+   if( len == 0 )
+      return 0;
+
+   if( svg && len <= SVG_TEXT_CACHE_LEN )
+   {
+      HB_U64 hash = svg_hash_bytes( ( HB_U64 ) face, text, len );
+      SVG_TEXT_ENTRY *entry;
+
+      if( svg->text_cache == NULL )
+      {
+         svg->text_cache = ( SVG_TEXT_CACHE * ) hb_xgrab( sizeof( SVG_TEXT_CACHE ) );
+         memset( svg->text_cache, 0, sizeof( SVG_TEXT_CACHE ) );
+      }
+      entry = &svg->text_cache->entries[ hash & ( SVG_TEXT_CACHE_SIZE - 1 ) ];
+
+      if( entry->hash == hash && entry->face == face && entry->len == len && memcmp( entry->text, text, len ) == 0 )
+      {
+         units = entry->units;
+      }
+      else
+      {
+         units = svg_font_units( face, text, len );
+
+         entry->hash = hash;
+         entry->units = units;
+         entry->face = ( HB_BYTE ) face;
+         entry->len = ( HB_BYTE ) len;
+         memcpy( entry->text, text, len );
+      }
+   }
+   else
+   {
+      units = svg_font_units( face, text, len );
+   }
+
+   return units * ( double ) size / 1000.0;
+}
+
+void svg_text_cache_free( SVG *svg )
+{
+   if( svg->text_cache )
+   {
+      hb_xfree( svg->text_cache );
+      svg->text_cache = NULL;
+   }
+}
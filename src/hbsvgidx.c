@@ -0,0 +1,374 @@
+/*
+ * Harbour Scalable Vector Graphics (HBSVG) Project
+ * Copyright 2014 - 2024 Rafał Jopek
+ * Website: https://harbour.pl
+ *
+ */
+
+/*
+ * Spatial index over emitted elements.
+ *
+ * Element boxes are recorded in a packed array while the document is drawn
+ * and bulk-loaded into a static R-tree (Hilbert sort, fixed node size) when
+ * the first query arrives or the handle is closed.
+ *
+ * Index file layout, native byte order, every field 32 bits wide:
+ *
+ *    "HBSVGIX1"                 magic, 8 bytes
+ *    count                      number of indexed elements
+ *    node_size                  children per node
+ *    num_nodes                  leaves + all upper levels
+ *    num_levels
+ *    level_bounds[ num_levels ] end position of each level in nodes[]
+ *    nodes[ num_nodes ]         x0, y0, x1, y1
+ *    indices[ num_nodes ]       leaf: element id - 1, node: first child
+ *
+ * The root is the last node. All arrays are 4-byte aligned, so the file
+ * can be memory-mapped and walked in place.
+ */
+
+#include "hbsvg.h"
+
+#define SVG_INDEX_NODE_SIZE  16
+#define SVG_INDEX_MAGIC      "HBSVGIX1"
+
+typedef struct
+{
+   HB_U32 hilbert;
+   HB_U32 item;
+} SVG_HILBERT;
+
+/* ------------------------------------------------------------------------- */
+// static
+static HB_U32 svg_hilbert( HB_U32 x, HB_U32 y )
+{
+   HB_U32 d = 0;
+
+   for( HB_U32 s = 1 << 15; s > 0; s >>= 1 )
+   {
+      HB_U32 rx = ( x & s ) > 0;
+      HB_U32 ry = ( y & s ) > 0;
+
+      d += s * s * ( ( 3 * rx ) ^ ry );
+
+      // Rotate the quadrant
+      if( ry == 0 )
+      {
+         if( rx == 1 )
+         {
+            x = 0xFFFF - x;
+            y = 0xFFFF - y;
+         }
+
+         HB_U32 t = x;
+         x = y;
+         y = t;
+      }
+   }
+
+   return d;
+}
+
+static int svg_hilbert_cmp( const void *p1, const void *p2 )
+{
+   const SVG_HILBERT *h1 = ( const SVG_HILBERT * ) p1;
+   const SVG_HILBERT *h2 = ( const SVG_HILBERT * ) p2;
+
+   if( h1->hilbert != h2->hilbert )
+      return h1->hilbert < h2->hilbert ? -1 : 1;
+
+   return h1->item < h2->item ? -1 : ( h1->item > h2->item );
+}
+
+static int svg_id_cmp( const void *p1, const void *p2 )
+{
+   HB_U32 id1 = *( const HB_U32 * ) p1;
+   HB_U32 id2 = *( const HB_U32 * ) p2;
+
+   return id1 < id2 ? -1 : ( id1 > id2 );
+}
+
+static void svg_index_release_tree( SVG_INDEX *index )
+{
+   if( index->nodes )
+   {
+      hb_xfree( index->nodes );
+      index->nodes = NULL;
+   }
+   if( index->indices )
+   {
+      hb_xfree( index->indices );
+      index->indices = NULL;
+   }
+   if( index->level_bounds )
+   {
+      hb_xfree( index->level_bounds );
+      index->level_bounds = NULL;
+   }
+   index->num_nodes = 0;
+   index->num_levels = 0;
+}
+
+/* ------------------------------------------------------------------------- */
+SVG_INDEX *svg_index_new( void )
+{
+   SVG_INDEX *index = ( SVG_INDEX * ) hb_xgrab( sizeof( SVG_INDEX ) );
+
+   memset( index, 0, sizeof( SVG_INDEX ) );
+   index->dirty = T;
+
+   return index;
+}
+
+void svg_index_free( SVG_INDEX *index )
+{
+   if( index )
+   {
+      svg_index_release_tree( index );
+      if( index->items )
+      {
+         hb_xfree( index->items );
+      }
+      hb_xfree( index );
+   }
+}
+
+void svg_index_add( SVG_INDEX *index, int x0, int y0, int x1, int y1 )
+{
+   if( index->count == index->capacity )
+   {
+      index->capacity = index->capacity ? index->capacity * 2 : 256;
+      index->items = ( SVG_BOX * ) hb_xrealloc( index->items, index->capacity * sizeof( SVG_BOX ) );
+   }
+
+   SVG_BOX *box = &index->items[ index->count++ ];
+
+   box->x0 = x0 < x1 ? x0 : x1;
+   box->y0 = y0 < y1 ? y0 : y1;
+   box->x1 = x0 < x1 ? x1 : x0;
+   box->y1 = y0 < y1 ? y1 : y0;
+
+   index->dirty = T;
+}
+
+void svg_index_build( SVG_INDEX *index )
+{
+   HB_SIZE count = index->count;
+
+   if( ! index->dirty )
+      return;
+
+   svg_index_release_tree( index );
+   index->dirty = F;
+
+   if( count == 0 )
+      return;
+
+   // Number of nodes on every level, leaves first
+   HB_SIZE num_nodes = count;
+   HB_SIZE level_count = count;
+   int num_levels = 1;
+
+   do
+   {
+      level_count = ( level_count + SVG_INDEX_NODE_SIZE - 1 ) / SVG_INDEX_NODE_SIZE;
+      num_nodes += level_count;
+      num_levels++;
+   }
+   while( level_count != 1 );
+
+   index->nodes = ( SVG_BOX * ) hb_xgrab( num_nodes * sizeof( SVG_BOX ) );
+   index->indices = ( HB_U32 * ) hb_xgrab( num_nodes * sizeof( HB_U32 ) );
+   index->level_bounds = ( HB_SIZE * ) hb_xgrab( num_levels * sizeof( HB_SIZE ) );
+   index->num_nodes = num_nodes;
+   index->num_levels = num_levels;
+
+   level_count = count;
+   index->level_bounds[ 0 ] = count;
+   for( int i = 1; i < num_levels; ++i )
+   {
+      level_count = ( level_count + SVG_INDEX_NODE_SIZE - 1 ) / SVG_INDEX_NODE_SIZE;
+      index->level_bounds[ i ] = index->level_bounds[ i - 1 ] + level_count;
+   }
+
+   // Extent of the whole scene, used to map box centres onto the Hilbert curve
+   SVG_BOX extent = index->items[ 0 ];
+   for( HB_SIZE i = 1; i < count; ++i )
+   {
+      const SVG_BOX *box = &index->items[ i ];
+
+      if( box->x0 < extent.x0 ) extent.x0 = box->x0;
+      if( box->y0 < extent.y0 ) extent.y0 = box->y0;
+      if( box->x1 > extent.x1 ) extent.x1 = box->x1;
+      if( box->y1 > extent.y1 ) extent.y1 = box->y1;
+   }
+
+   double width = ( double ) extent.x1 - extent.x0;
+   double height = ( double ) extent.y1 - extent.y0;
+   double sx = width > 0 ? 0xFFFF / width : 0;
+   double sy = height > 0 ? 0xFFFF / height : 0;
+
+   SVG_HILBERT *order = ( SVG_HILBERT * ) hb_xgrab( count * sizeof( SVG_HILBERT ) );
+
+   for( HB_SIZE i = 0; i < count; ++i )
+   {
+      const SVG_BOX *box = &index->items[ i ];
+      double cx = ( ( ( double ) box->x0 + box->x1 ) / 2 - extent.x0 ) * sx;
+      double cy = ( ( ( double ) box->y0 + box->y1 ) / 2 - extent.y0 ) * sy;
+
+      order[ i ].hilbert = svg_hilbert( ( HB_U32 ) cx, ( HB_U32 ) cy );
+      order[ i ].item = ( HB_U32 ) i;
+   }
+
+   qsort( order, count, sizeof( SVG_HILBERT ), svg_hilbert_cmp );
+
+   for( HB_SIZE i = 0; i < count; ++i )
+   {
+      index->nodes[ i ] = index->items[ order[ i ].item ];
+      index->indices[ i ] = order[ i ].item;
+   }
+
+   hb_xfree( order );
+
+   // Every parent covers up to SVG_INDEX_NODE_SIZE consecutive children
+   HB_SIZE pos = 0;
+   HB_SIZE parent = count;
+
+   for( int level = 0; level < num_levels - 1; ++level )
+   {
+      HB_SIZE end = index->level_bounds[ level ];
+
+      while( pos < end )
+      {
+         SVG_BOX box = index->nodes[ pos ];
+         HB_SIZE first = pos;
+
+         for( int i = 0; i < SVG_INDEX_NODE_SIZE && pos < end; ++i, ++pos )
+         {
+            const SVG_BOX *child = &index->nodes[ pos ];
+
+            if( child->x0 < box.x0 ) box.x0 = child->x0;
+            if( child->y0 < box.y0 ) box.y0 = child->y0;
+            if( child->x1 > box.x1 ) box.x1 = child->x1;
+            if( child->y1 > box.y1 ) box.y1 = child->y1;
+         }
+
+         index->nodes[ parent ] = box;
+         index->indices[ parent ] = ( HB_U32 ) first;
+         parent++;
+      }
+   }
+}
+
+/* Collects the ids of all elements whose box intersects the query box.
+   The ids are 1-based drawing order, sorted ascending. Returns the count;
+   *results must be released with hb_xfree() when not NULL. */
+HB_SIZE svg_index_query( SVG_INDEX *index, int x0, int y0, int x1, int y1, HB_U32 **results )
+{
+   HB_SIZE found = 0;
+   HB_SIZE capacity = 0;
+   HB_U32 *ids = NULL;
+
+   svg_index_build( index );
+
+   *results = NULL;
+
+   if( index->num_nodes == 0 )
+      return 0;
+
+   // Depth of the tree is bounded by num_levels, and every visited node pushes at most SVG_INDEX_NODE_SIZE children
+   HB_SIZE *stack = ( HB_SIZE * ) hb_xgrab( ( index->num_levels * SVG_INDEX_NODE_SIZE + 1 ) * sizeof( HB_SIZE ) );
+   HB_SIZE top = 0;
+
+   stack[ top++ ] = index->num_nodes - 1;
+
+   while( top )
+   {
+      HB_SIZE node = stack[ --top ];
+      HB_SIZE end = node + SVG_INDEX_NODE_SIZE;
+
+      // Children never cross the boundary of their level
+      for( int level = 0; level < index->num_levels; ++level )
+      {
+         if( index->level_bounds[ level ] > node )
+         {
+            if( index->level_bounds[ level ] < end )
+               end = index->level_bounds[ level ];
+            break;
+         }
+      }
+
+      for( HB_SIZE pos = node; pos < end; ++pos )
+      {
+         const SVG_BOX *box = &index->nodes[ pos ];
+
+         if( box->x1 < x0 || box->x0 > x1 || box->y1 < y0 || box->y0 > y1 )
+            continue;
+
+         if( pos < index->count )
+         {
+            if( found == capacity )
+            {
+               capacity = capacity ? capacity * 2 : 16;
+               ids = ( HB_U32 * ) hb_xrealloc( ids, capacity * sizeof( HB_U32 ) );
+            }
+            ids[ found++ ] = index->indices[ pos ] + 1;
+         }
+         else
+         {
+            stack[ top++ ] = index->indices[ pos ];
+         }
+      }
+   }
+
+   hb_xfree( stack );
+
+   // Restore drawing order
+   if( found > 1 )
+   {
+      qsort( ids, found, sizeof( HB_U32 ), svg_id_cmp );
+   }
+
+   *results = ids;
+   return found;
+}
+
+bool svg_index_save( SVG_INDEX *index, const char *filename )
+{
+   FILE *file = fopen( filename, "wb" );
+   bool ok;
+
+   if( file == NULL )
+   {
+      fprintf( stderr, "Error: Could not open file '%s' for writing.\n", filename );
+      return F;
+   }
+
+   svg_index_build( index );
+
+   HB_U32 header[ 4 ];
+   header[ 0 ] = ( HB_U32 ) index->count;
+   header[ 1 ] = SVG_INDEX_NODE_SIZE;
+   header[ 2 ] = ( HB_U32 ) index->num_nodes;
+   header[ 3 ] = ( HB_U32 ) index->num_levels;
+
+   ok = fwrite( SVG_INDEX_MAGIC, 8, 1, file ) == 1 &&
+        fwrite( header, sizeof( header ), 1, file ) == 1;
+
+   for( int i = 0; ok && i < index->num_levels; ++i )
+   {
+      HB_U32 bound = ( HB_U32 ) index->level_bounds[ i ];
+      ok = fwrite( &bound, sizeof( bound ), 1, file ) == 1;
+   }
+
+   if( ok && index->num_nodes )
+   {
+      ok = fwrite( index->nodes, sizeof( SVG_BOX ), index->num_nodes, file ) == index->num_nodes &&
+           fwrite( index->indices, sizeof( HB_U32 ), index->num_nodes, file ) == index->num_nodes;
+   }
+
+   if( fclose( file ) != 0 )
+      ok = F;
+
+   return ok;
+}
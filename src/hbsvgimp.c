@@ -0,0 +1,689 @@
+/*
+ * Harbour Scalable Vector Graphics (HBSVG) Project
+ * Copyright 2014 - 2024 Rafał Jopek
+ * Website: https://harbour.pl
+ *
+ */
+
+/*
+ * SVG templates.
+ *
+ * The template file is memory-mapped and scanned once, tag by tag, with
+ * memchr() doing the searching. The prolog, comments and the outer <svg>
+ * element are dropped; everything inside the outer element is written
+ * unchanged except for ids: every id defined in the template gets a prefix
+ * unique to the import, and id="...", url(#...) ( also quoted ),
+ * href="#..." and #... selectors in <style> are rewritten to match. Inside
+ * style declarations only url() is a reference, #abc there is a colour.
+ * References to ids the template does not define are left alone, so a
+ * template can still use gradients of the document.
+ */
+
+#include "hbsvg.h"
+
+typedef struct
+{
+   const char *name;
+   HB_SIZE len;
+} SVG_SLICE;
+
+/* Set of the ids defined in a template, open addressing over slices of the file */
+typedef struct
+{
+   SVG_SLICE *slots;
+   HB_SIZE mask;
+   HB_SIZE count;
+} SVG_IDSET;
+
+/* ------------------------------------------------------------------------- */
+// static
+static HB_U32 svg_idset_hash( const char *name, HB_SIZE len )
+{
+   HB_U32 hash = 2166136261u;
+
+   for( HB_SIZE i = 0; i < len; ++i )
+   {
+      hash = ( hash ^ ( unsigned char ) name[ i ] ) * 16777619u;
+   }
+
+   return hash;
+}
+
+static void svg_idset_add( SVG_IDSET *set, const char *name, HB_SIZE len );
+
+static void svg_idset_grow( SVG_IDSET *set )
+{
+   SVG_SLICE *slots = set->slots;
+   HB_SIZE size = set->slots ? set->mask + 1 : 0;
+
+   set->mask = size ? size * 2 - 1 : 63;
+   set->slots = ( SVG_SLICE * ) hb_xgrab( ( set->mask + 1 ) * sizeof( SVG_SLICE ) );
+   memset( set->slots, 0, ( set->mask + 1 ) * sizeof( SVG_SLICE ) );
+   set->count = 0;
+
+   for( HB_SIZE i = 0; i < size; ++i )
+   {
+      if( slots[ i ].name )
+      {
+         svg_idset_add( set, slots[ i ].name, slots[ i ].len );
+      }
+   }
+
+   if( slots )
+   {
+      hb_xfree( slots );
+   }
+}
+
+static bool svg_idset_has( const SVG_IDSET *set, const char *name, HB_SIZE len )
+{
+   if( set->count == 0 )
+      return F;
+
+   for( HB_SIZE i = svg_idset_hash( name, len ) & set->mask; set->slots[ i ].name; i = ( i + 1 ) & set->mask )
+   {
+      if( set->slots[ i ].len == len && memcmp( set->slots[ i ].name, name, len ) == 0 )
+         return T;
+   }
+
+   return F;
+}
+
+static void svg_idset_add( SVG_IDSET *set, const char *name, HB_SIZE len )
+{
+   if( set->slots == NULL || ( set->count + 1 ) * 2 > set->mask + 1 )
+   {
+      svg_idset_grow( set );
+   }
+
+   HB_SIZE i = svg_idset_hash( name, len ) & set->mask;
+
+   while( set->slots[ i ].name )
+   {
+      if( set->slots[ i ].len == len && memcmp( set->slots[ i ].name, name, len ) == 0 )
+         return;
+      i = ( i + 1 ) & set->mask;
+   }
+
+   set->slots[ i ].name = name;
+   set->slots[ i ].len = len;
+   set->count++;
+}
+
+static bool svg_is_space( char c )
+{
+   return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+/* Characters of a CSS identifier, escapes aside */
+static bool svg_is_name( char c )
+{
+   return ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' ) || ( c >= '0' && c <= '9' ) ||
+          c == '-' || c == '_' || ( unsigned char ) c >= 0x80;
+}
+
+static const char *svg_find( const char *p, const char *end, const char *what )
+{
+   HB_SIZE len = strlen( what );
+
+   while( ( p = ( const char * ) memchr( p, what[ 0 ], end - p ) ) != NULL )
+   {
+      if( ( HB_SIZE ) ( end - p ) < len )
+         return NULL;
+      if( memcmp( p, what, len ) == 0 )
+         return p;
+      p++;
+   }
+
+   return NULL;
+}
+
+/* End of a tag: the '>' outside of quoted attribute values */
+static const char *svg_tag_end( const char *p, const char *end )
+{
+   while( p < end )
+   {
+      if( *p == '"' || *p == '\'' )
+      {
+         const char *q = ( const char * ) memchr( p + 1, *p, end - p - 1 );
+         if( q == NULL )
+            return NULL;
+         p = q + 1;
+      }
+      else if( *p == '>' )
+      {
+         return p;
+      }
+      else
+      {
+         p++;
+      }
+   }
+
+   return NULL;
+}
+
+/* Skips markup that is not an element: declarations, processing instructions and comments */
+static const char *svg_skip_markup( const char *p, const char *end )
+{
+   const char *q;
+
+   if( end - p >= 4 && memcmp( p, "<!--", 4 ) == 0 )
+   {
+      q = svg_find( p + 4, end, "-->" );
+      return q ? q + 3 : end;
+   }
+   if( end - p >= 2 && p[ 1 ] == '?' )
+   {
+      q = svg_find( p + 2, end, "?>" );
+      return q ? q + 2 : end;
+   }
+
+   // <!DOCTYPE ... [ internal subset ]>
+   q = svg_tag_end( p, end );
+   if( q )
+   {
+      const char *subset = ( const char * ) memchr( p, '[', q - p );
+      if( subset )
+      {
+         q = svg_find( subset, end, "]>" );
+         return q ? q + 2 : end;
+      }
+      return q + 1;
+   }
+
+   return end;
+}
+
+static bool svg_tag_is( const char *p, const char *end, const char *name )
+{
+   HB_SIZE len = strlen( name );
+
+   return ( HB_SIZE ) ( end - p ) > len && memcmp( p, name, len ) == 0 &&
+          ( svg_is_space( p[ len ] ) || p[ len ] == '>' || p[ len ] == '/' );
+}
+
+/* Calls back for every attribute of the tag that starts at p ( after the name ) */
+typedef void ( *SVG_ATTR_FUNC )( void *cargo, const char *name, HB_SIZE name_len, const char *value, HB_SIZE value_len );
+
+static void svg_attributes( const char *p, const char *end, SVG_ATTR_FUNC func, void *cargo )
+{
+   while( p < end )
+   {
+      while( p < end && svg_is_space( *p ) )
+         p++;
+
+      const char *name = p;
+      while( p < end && *p != '=' && ! svg_is_space( *p ) && *p != '>' && *p != '/' )
+         p++;
+
+      HB_SIZE name_len = p - name;
+
+      while( p < end && svg_is_space( *p ) )
+         p++;
+
+      if( p >= end || *p != '=' )
+      {
+         if( name_len == 0 )
+            p++;
+         continue;
+      }
+
+      p++;
+      while( p < end && svg_is_space( *p ) )
+         p++;
+
+      if( p >= end || ( *p != '"' && *p != '\'' ) )
+         continue;
+
+      const char *value = p + 1;
+      const char *close = ( const char * ) memchr( value, *p, end - value );
+      if( close == NULL )
+         return;
+
+      func( cargo, name, name_len, value, close - value );
+      p = close + 1;
+   }
+}
+
+static void svg_collect_id( void *cargo, const char *name, HB_SIZE name_len, const char *value, HB_SIZE value_len )
+{
+   if( name_len == 2 && memcmp( name, "id", 2 ) == 0 && value_len )
+   {
+      svg_idset_add( ( SVG_IDSET * ) cargo, value, value_len );
+   }
+}
+
+static void svg_outer_attribute( void *cargo, const char *name, HB_SIZE name_len, const char *value, HB_SIZE value_len )
+{
+   SVG_TEMPLATE *tpl = ( SVG_TEMPLATE * ) cargo;
+   char buffer[ 128 ];
+
+   // Prefixed namespaces ( xlink, ... ) are still needed by the content
+   if( name_len > 6 && memcmp( name, "xmlns:", 6 ) == 0 )
+   {
+      svg_buffer_append( &tpl->namespaces, " ", 1 );
+      svg_buffer_append( &tpl->namespaces, name, value + value_len + 1 - name );
+      return;
+   }
+
+   if( value_len >= sizeof( buffer ) )
+      return;
+
+   memcpy( buffer, value, value_len );
+   buffer[ value_len ] = '\0';
+
+   if( name_len == 5 && memcmp( name, "width", 5 ) == 0 && ! memchr( buffer, '%', value_len ) )
+   {
+      tpl->width = strtod( buffer, NULL );
+   }
+   else if( name_len == 6 && memcmp( name, "height", 6 ) == 0 && ! memchr( buffer, '%', value_len ) )
+   {
+      tpl->height = strtod( buffer, NULL );
+   }
+   else if( name_len == 7 && memcmp( name, "viewBox", 7 ) == 0 )
+   {
+      double vb[ 4 ];
+      char *p = buffer;
+      int i;
+
+      for( i = 0; i < 4; ++i )
+      {
+         char *next;
+
+         while( *p == ',' || svg_is_space( *p ) )
+            p++;
+         vb[ i ] = strtod( p, &next );
+         if( next == p )
+            break;
+         p = next;
+      }
+
+      if( i == 4 && vb[ 2 ] > 0 && vb[ 3 ] > 0 )
+      {
+         tpl->vb_x = vb[ 0 ];
+         tpl->vb_y = vb[ 1 ];
+         tpl->vb_w = vb[ 2 ];
+         tpl->vb_h = vb[ 3 ];
+         tpl->has_viewbox = T;
+      }
+   }
+}
+
+typedef struct
+{
+   const SVG_IDSET *ids;
+   const char *prefix;
+   HB_SIZE prefix_len;
+   SVG_WRITE_FUNC write;
+   void *cargo;
+   bool style;          // inside <style>: #id selectors are references too
+   bool decl;           // inside a { ... } declaration block of the style sheet
+   bool group;          // the pending @ rule holds rules, not declarations
+   bool comment;        // inside a style sheet comment
+} SVG_REWRITER;
+
+/* Writes a span, prefixing every url(#id), url('#id') and url("#id")
+   reference to a template id */
+static void svg_write_refs( SVG_REWRITER *rw, const char *p, const char *end )
+{
+   const char *from = p;
+
+   while( ( p = ( const char * ) memchr( p, '#', end - p ) ) != NULL )
+   {
+      const char *id = p + 1;
+      const char *q = id;
+      const char *url = p;
+
+      if( url > from && ( url[ -1 ] == '"' || url[ -1 ] == '\'' ) )
+         url--;
+      while( url > from && svg_is_space( url[ -1 ] ) )
+         url--;
+
+      if( url - from >= 4 && memcmp( url - 4, "url(", 4 ) == 0 )
+      {
+         while( q < end && *q != ')' && *q != '"' && *q != '\'' && ! svg_is_space( *q ) )
+            q++;
+      }
+
+      if( q > id && svg_idset_has( rw->ids, id, q - id ) )
+      {
+         rw->write( rw->cargo, from, id - from );
+         rw->write( rw->cargo, rw->prefix, rw->prefix_len );
+         from = id;
+      }
+      p = q > id ? q : id;
+   }
+
+   rw->write( rw->cargo, from, end - from );
+}
+
+/* Writes a span of a style sheet. #id is rewritten at selector positions
+   only; declaration blocks go through svg_write_refs(), so a colour like
+   fill:#abc keeps its value when the template also has id="abc". The state
+   carries over from span to span ( text, CDATA ) until </style>. */
+static void svg_write_style( SVG_REWRITER *rw, const char *p, const char *end )
+{
+   const char *from = p;
+
+   while( p < end )
+   {
+      if( rw->comment )
+      {
+         const char *close = svg_find( p, end, "*/" );
+
+         if( close == NULL )
+            break;
+         rw->comment = F;
+         p = close + 2;
+      }
+      else if( rw->decl )
+      {
+         const char *close = ( const char * ) memchr( p, '}', end - p );
+
+         if( close == NULL )
+         {
+            svg_write_refs( rw, from, end );
+            return;
+         }
+         svg_write_refs( rw, from, close + 1 );
+         rw->decl = F;
+         from = p = close + 1;
+      }
+      else if( *p == '/' && p + 1 < end && p[ 1 ] == '*' )
+      {
+         rw->comment = T;
+         p += 2;
+      }
+      else if( *p == '@' )
+      {
+         const char *name = ++p;
+
+         while( p < end && svg_is_name( *p ) )
+            p++;
+
+         // Conditional group rules nest rules; @font-face, @page, ... hold declarations
+         rw->group = ( p - name == 5 && memcmp( name, "media", 5 ) == 0 ) ||
+                     ( p - name == 8 && memcmp( name, "supports", 8 ) == 0 ) ||
+                     ( p - name == 9 && memcmp( name, "container", 9 ) == 0 ) ||
+                     ( p - name == 5 && memcmp( name, "layer", 5 ) == 0 ) ||
+                     ( p - name == 8 && memcmp( name, "document", 8 ) == 0 );
+      }
+      else if( *p == '{' )
+      {
+         if( rw->group )
+            rw->group = F;
+         else
+            rw->decl = T;
+         p++;
+      }
+      else if( *p == ';' )
+      {
+         // End of a statement such as @import
+         rw->group = F;
+         p++;
+      }
+      else if( *p == '#' )
+      {
+         const char *id = ++p;
+
+         while( p < end && svg_is_name( *p ) )
+            p++;
+
+         if( p > id && svg_idset_has( rw->ids, id, p - id ) )
+         {
+            rw->write( rw->cargo, from, id - from );
+            rw->write( rw->cargo, rw->prefix, rw->prefix_len );
+            from = id;
+         }
+      }
+      else
+      {
+         p++;
+      }
+   }
+
+   rw->write( rw->cargo, from, end - from );
+}
+
+/* Writes character data: a style sheet inside <style>, references elsewhere */
+static void svg_write_text( SVG_REWRITER *rw, const char *p, const char *end )
+{
+   if( rw->style )
+      svg_write_style( rw, p, end );
+   else
+      svg_write_refs( rw, p, end );
+}
+
+/* Writes a start tag with its id and references rewritten */
+static void svg_write_tag( SVG_REWRITER *rw, const char *p, const char *end )
+{
+   const char *from = p;
+
+   // Skip the tag name
+   while( p < end && ! svg_is_space( *p ) && *p != '>' && *p != '/' )
+      p++;
+
+   while( p < end )
+   {
+      while( p < end && svg_is_space( *p ) )
+         p++;
+
+      const char *name = p;
+      while( p < end && *p != '=' && ! svg_is_space( *p ) && *p != '>' && *p != '/' )
+         p++;
+
+      HB_SIZE name_len = p - name;
+
+      while( p < end && ( svg_is_space( *p ) || *p == '=' ) )
+         p++;
+
+      if( p >= end || ( *p != '"' && *p != '\'' ) )
+      {
+         if( name_len == 0 && p < end )
+            p++;
+         continue;
+      }
+
+      const char *value = p + 1;
+      const char *close = ( const char * ) memchr( value, *p, end - value );
+      if( close == NULL )
+         break;
+
+      HB_SIZE value_len = close - value;
+
+      if( name_len == 2 && memcmp( name, "id", 2 ) == 0 )
+      {
+         svg_write_refs( rw, from, value );
+         rw->write( rw->cargo, rw->prefix, rw->prefix_len );
+         from = value;
+      }
+      else if( ( ( name_len == 4 && memcmp( name, "href", 4 ) == 0 ) ||
+                 ( name_len == 10 && memcmp( name, "xlink:href", 10 ) == 0 ) ) &&
+               value_len > 1 && value[ 0 ] == '#' && svg_idset_has( rw->ids, value + 1, value_len - 1 ) )
+      {
+         svg_write_refs( rw, from, value + 1 );
+         rw->write( rw->cargo, rw->prefix, rw->prefix_len );
+         from = value + 1;
+      }
+
+      p = close + 1;
+   }
+
+   svg_write_refs( rw, from, end );
+}
+
+/* Finds the outer <svg> start tag, skipping the prolog */
+static bool svg_template_parse( SVG_TEMPLATE *tpl )
+{
+   const char *p = tpl->data;
+   const char *end = tpl->data + tpl->size;
+
+   while( ( p = ( const char * ) memchr( p, '<', end - p ) ) != NULL )
+   {
+      if( p + 1 < end && ( p[ 1 ] == '?' || p[ 1 ] == '!' ) )
+      {
+         p = svg_skip_markup( p, end );
+         continue;
+      }
+
+      const char *close = svg_tag_end( p, end );
+
+      if( close == NULL || ! svg_tag_is( p + 1, end, "svg" ) )
+         break;
+
+      svg_attributes( p + 4, close, svg_outer_attribute, tpl );
+
+      tpl->empty = close[ -1 ] == '/';
+      tpl->body = ( close + 1 ) - tpl->data;
+      return T;
+   }
+
+   svg_template_close( tpl );
+   return F;
+}
+
+/* ------------------------------------------------------------------------- */
+bool svg_template_open( SVG_TEMPLATE *tpl, const char *filename )
+{
+   memset( tpl, 0, sizeof( SVG_TEMPLATE ) );
+
+   tpl->data = svg_file_map( filename, &tpl->size );
+   if( tpl->data == NULL )
+      return F;
+
+   tpl->mapped = T;
+   return svg_template_parse( tpl );
+}
+
+/* Template from markup in memory, which must outlive tpl */
+bool svg_template_open_data( SVG_TEMPLATE *tpl, const char *data, HB_SIZE size )
+{
+   memset( tpl, 0, sizeof( SVG_TEMPLATE ) );
+
+   tpl->data = data;
+   tpl->size = size;
+   return svg_template_parse( tpl );
+}
+
+void svg_template_close( SVG_TEMPLATE *tpl )
+{
+   if( tpl->data && tpl->mapped )
+   {
+      svg_file_unmap( tpl->data, tpl->size );
+   }
+   tpl->data = NULL;
+   svg_buffer_free( &tpl->namespaces );
+}
+
+/* Writes the content of the outer <svg> element with ids prefixed by prefix */
+void svg_template_write( SVG_TEMPLATE *tpl, const char *prefix, SVG_WRITE_FUNC write, void *cargo )
+{
+   const char *begin = tpl->data + tpl->body;
+   const char *end = tpl->data + tpl->size;
+   const char *p;
+   SVG_IDSET ids;
+   SVG_REWRITER rw;
+
+   if( tpl->empty )
+      return;
+
+   // First pass: the ids the template defines
+   memset( &ids, 0, sizeof( SVG_IDSET ) );
+
+   for( p = begin; ( p = ( const char * ) memchr( p, '<', end - p ) ) != NULL; )
+   {
+      if( p + 1 < end && ( p[ 1 ] == '!' || p[ 1 ] == '?' ) )
+      {
+         p = svg_skip_markup( p, end );
+         continue;
+      }
+
+      const char *close = svg_tag_end( p, end );
+      if( close == NULL )
+         break;
+
+      if( p[ 1 ] != '/' )
+      {
+         svg_attributes( p + 1, close, svg_collect_id, &ids );
+      }
+      p = close + 1;
+   }
+
+   // Second pass: copy the body
+   rw.ids = &ids;
+   rw.prefix = prefix;
+   rw.prefix_len = strlen( prefix );
+   rw.write = write;
+   rw.cargo = cargo;
+   rw.style = F;
+   rw.decl = F;
+   rw.group = F;
+   rw.comment = F;
+
+   int depth = 1;
+   const char *text = begin;
+
+   for( p = begin; ( p = ( const char * ) memchr( p, '<', end - p ) ) != NULL; )
+   {
+      svg_write_text( &rw, text, p );
+
+      if( p + 1 < end && p[ 1 ] == '!' && end - p >= 9 && memcmp( p, "<![CDATA[", 9 ) == 0 )
+      {
+         const char *close = svg_find( p + 9, end, "]]>" );
+
+         close = close ? close + 3 : end;
+         svg_write_text( &rw, p, close );
+         text = p = close;
+         continue;
+      }
+
+      if( p + 1 < end && ( p[ 1 ] == '!' || p[ 1 ] == '?' ) )
+      {
+         text = p = svg_skip_markup( p, end );
+         continue;
+      }
+
+      const char *close = svg_tag_end( p, end );
+      if( close == NULL )
+      {
+         text = end;
+         break;
+      }
+
+      if( p[ 1 ] == '/' )
+      {
+         if( svg_tag_is( p + 2, end, "svg" ) && --depth == 0 )
+         {
+            text = end;
+            break;
+         }
+         if( svg_tag_is( p + 2, end, "style" ) )
+            rw.style = F;
+         write( cargo, p, close + 1 - p );
+      }
+      else
+      {
+         if( svg_tag_is( p + 1, end, "svg" ) && close[ -1 ] != '/' )
+            depth++;
+         if( svg_tag_is( p + 1, end, "style" ) && close[ -1 ] != '/' )
+         {
+            rw.style = T;
+            rw.decl = rw.group = rw.comment = F;
+         }
+         svg_write_tag( &rw, p, close + 1 );
+      }
+
+      text = p = close + 1;
+   }
+
+   if( text < end )
+   {
+      svg_write_text( &rw, text, end );
+   }
+
+   if( ids.slots )
+   {
+      hb_xfree( ids.slots );
+   }
+}
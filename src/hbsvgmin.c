@@ -0,0 +1,95 @@
+/*
+ * Harbour Scalable Vector Graphics (HBSVG) Project
+ * Copyright 2014 - 2024 Rafał Jopek
+ * Website: https://harbour.pl
+ *
+ */
+
+/*
+ * Minified output.
+ *
+ * Minification happens while the document is written: every call site picks
+ * a compact format string without layout whitespace, colours take their
+ * shortest form and attributes equal to SVG defaults are left out. Argument
+ * values (text content, ids) are never touched.
+ */
+
+#include "hbsvg.h"
+
+typedef struct
+{
+   unsigned int color;
+   const char *name;
+} SVG_COLOR_NAME;
+
+/* Colour keywords shorter than their shortest hex form, sorted by value */
+static const SVG_COLOR_NAME s_colorNames[] =
+{
+   { 0x000080, "navy"   },
+   { 0x008000, "green"  },
+   { 0x008080, "teal"   },
+   { 0x4B0082, "indigo" },
+   { 0x800000, "maroon" },
+   { 0x800080, "purple" },
+   { 0x808000, "olive"  },
+   { 0x808080, "gray"   },
+   { 0xA0522D, "sienna" },
+   { 0xA52A2A, "brown"  },
+   { 0xC0C0C0, "silver" },
+   { 0xCD853F, "peru"   },
+   { 0xD2B48C, "tan"    },
+   { 0xDA70D6, "orchid" },
+   { 0xDDA0DD, "plum"   },
+   { 0xEE82EE, "violet" },
+   { 0xF0E68C, "khaki"  },
+   { 0xF0FFFF, "azure"  },
+   { 0xF5DEB3, "wheat"  },
+   { 0xF5F5DC, "beige"  },
+   { 0xFA8072, "salmon" },
+   { 0xFAF0E6, "linen"  },
+   { 0xFF0000, "red"    },
+   { 0xFF6347, "tomato" },
+   { 0xFF7F50, "coral"  },
+   { 0xFFA500, "orange" },
+   { 0xFFC0CB, "pink"   },
+   { 0xFFD700, "gold"   },
+   { 0xFFE4C4, "bisque" },
+   { 0xFFFAFA, "snow"   },
+   { 0xFFFFF0, "ivory"  }
+};
+
+/* ------------------------------------------------------------------------- */
+/* Writes the shortest form of an RGB colour: keyword, #rgb or #rrggbb */
+void svg_color_short( char *buffer, unsigned int color )
+{
+   int lo = 0;
+   int hi = ( int ) HB_SIZEOFARRAY( s_colorNames ) - 1;
+
+   color &= 0xFFFFFF;
+
+   while( lo <= hi )
+   {
+      int mid = ( lo + hi ) / 2;
+
+      if( s_colorNames[ mid ].color == color )
+      {
+         strcpy( buffer, s_colorNames[ mid ].name );
+         return;
+      }
+
+      if( s_colorNames[ mid ].color < color )
+         lo = mid + 1;
+      else
+         hi = mid - 1;
+   }
+
+   // Every channel has equal nibbles: #aabbcc -> #abc
+   if( ( ( color >> 4 ) & 0x0F0F0F ) == ( color & 0x0F0F0F ) )
+   {
+      sprintf( buffer, "#%x%x%x", ( color >> 16 ) & 0x0F, ( color >> 8 ) & 0x0F, color & 0x0F );
+   }
+   else
+   {
+      sprintf( buffer, "#%06x", color );
+   }
+}
@@ -0,0 +1,883 @@
+/*
+ * Harbour Scalable Vector Graphics (HBSVG) Project
+ * Copyright 2014 - 2024 Rafał Jopek
+ * Website: https://harbour.pl
+ *
+ */
+
+/*
+ * Binary recording and replay.
+ *
+ * A handle opened with SVG_FLAG_RECORD also writes every call made on it to
+ * <cFileName>.svgb. svg_replay() calls the same functions again with the same
+ * arguments, so the SVG it writes is identical to the recorded one.
+ *
+ * File layout, all integers are unsigned LEB128 varints:
+ *
+ *    "HBSVGB1\n" <width> <height> <flags>
+ *    FUNC  <len> <name>          names the next function number
+ *    CALL  <func> <argc> <arg>*
+ *    END                         svg_close()
+ *
+ * Arguments are tagged. The handle is not stored. Whole numbers are zigzag
+ * coded differences to the previous whole number passed in the same argument
+ * of the same function, array elements to the element two places before (the
+ * other coordinate of the previous point), so coordinates of neighbouring
+ * elements take one or two bytes. Strings up to SVG_RECORD_INTERN bytes are
+ * stored once and then referred to by number; colour and font names repeat a
+ * lot. Other numbers are stored as 8 raw bytes.
+ *
+ * svg_import() is recorded with the template markup as a blob in place of
+ * the file name, so replay does not read the template file again.
+ *
+ * Only the drawing functions in s_replayable are recorded and replayed, and
+ * only with the replayed handle as their first argument, so a .svgb file
+ * cannot make svg_replay() call anything else.
+ */
+
+#include "hbsvg.h"
+
+#define SVG_RECORD_MAGIC    "HBSVGB1\n"
+#define SVG_RECORD_SLOTS    16          // arguments per function with their own delta base
+#define SVG_RECORD_INTERN   256         // longer strings are stored in place every time
+#define SVG_RECORD_FLUSH    0x10000
+
+// Records
+#define SVG_REC_END         0x00
+#define SVG_REC_FUNC        0x01
+#define SVG_REC_CALL        0x02
+
+// Arguments
+#define SVG_ARG_NIL         0x00
+#define SVG_ARG_HANDLE      0x01
+#define SVG_ARG_INT         0x02
+#define SVG_ARG_DOUBLE      0x03
+#define SVG_ARG_STRING      0x04        // interned string by number
+#define SVG_ARG_NEWSTR      0x05        // string interned as the next number
+#define SVG_ARG_FALSE       0x06
+#define SVG_ARG_TRUE        0x07
+#define SVG_ARG_ARRAY       0x08
+#define SVG_ARG_HASH        0x09
+#define SVG_ARG_BLOB        0x0A        // string not interned
+
+typedef struct
+{
+   char *name;
+   HB_I64 last[ SVG_RECORD_SLOTS ];
+} SVG_RECORD_FUNC;
+
+typedef struct
+{
+   HB_U64 hash;
+   HB_U32 id;                 // number + 1, 0 for an empty entry
+   HB_U32 len;
+   char *data;
+} SVG_RECORD_STRING;
+
+struct _SVG_RECORDER
+{
+   FILE *file;
+   SVG_BUFFER out;
+   bool error;
+
+   SVG_RECORD_FUNC *funcs;
+   HB_SIZE func_count;
+   HB_SIZE func_capacity;
+   HB_SIZE func_last;         // most recently called, tried first
+
+   SVG_RECORD_STRING *strings;   // open addressing, power of two
+   HB_SIZE string_count;
+   HB_SIZE string_capacity;
+};
+
+// Functions that write to the document, the only ones a recording may call
+static const char *s_replayable[] =
+{
+   "SVG_ARROW", "SVG_BEZIER_CURVE", "SVG_CIRCLE", "SVG_CIRCLE_GRADIENT", "SVG_ELLIPSE",
+   "SVG_FILLED_CIRCLE", "SVG_FILLED_ELLIPSE", "SVG_FILLED_HEXAGON", "SVG_FILLED_RECT",
+   "SVG_FILLED_TRIANGLE", "SVG_FIT_CURVE", "SVG_HEXAGON", "SVG_IMPORT", "SVG_LINE",
+   "SVG_LINEAR_GRADIENT", "SVG_LINE_CHART", "SVG_NUMBERED_ARROW", "SVG_NUMBERED_ARROW_XY",
+   "SVG_PATH_BEGIN", "SVG_PATH_CLOSE", "SVG_PATH_CURVETO", "SVG_PATH_END", "SVG_PATH_LINETO",
+   "SVG_PATH_MOVETO", "SVG_PATH_POINTS", "SVG_POLYLINE", "SVG_RADIAL_GRADIENT", "SVG_RECT",
+   "SVG_RECT_GRADIENT", "SVG_SET_BACKGROUND", "SVG_TEXT", "SVG_TEXT_ALIGNED", "SVG_TRIANGLE",
+   "SVG_TRIANGLE_LINEAR_GRADIENT", "SVG_TRIANGLE_RADIAL_GRADIENT"
+};
+
+static bool svg_replayable( const char *name, HB_SIZE len )
+{
+   for( HB_SIZE i = 0; i < HB_SIZEOFARRAY( s_replayable ); ++i )
+   {
+      if( strlen( s_replayable[ i ] ) == len && hb_strnicmp( s_replayable[ i ], name, len ) == 0 )
+         return T;
+   }
+   return F;
+}
+
+/* ------------------------------------------------------------------------- */
+// static
+static inline void svg_record_byte( SVG_RECORDER *rec, HB_BYTE value )
+{
+   rec->out.data[ rec->out.len++ ] = ( char ) value;
+}
+
+static inline void svg_record_varint( SVG_RECORDER *rec, HB_U64 value )
+{
+   while( value >= 0x80 )
+   {
+      rec->out.data[ rec->out.len++ ] = ( char ) ( value | 0x80 );
+      value >>= 7;
+   }
+   rec->out.data[ rec->out.len++ ] = ( char ) value;
+}
+
+static void svg_record_bytes( SVG_RECORDER *rec, const char *data, HB_SIZE len )
+{
+   svg_buffer_reserve( &rec->out, len + 16 );
+   svg_record_varint( rec, len );
+   memcpy( rec->out.data + rec->out.len, data, len );
+   rec->out.len += len;
+}
+
+static void svg_record_flush( SVG_RECORDER *rec )
+{
+   if( rec->out.len && ! rec->error && fwrite( rec->out.data, 1, rec->out.len, rec->file ) != rec->out.len )
+   {
+      rec->error = T;
+   }
+   rec->out.len = 0;
+}
+
+static HB_SIZE svg_record_func( SVG_RECORDER *rec, const char *name )
+{
+   if( rec->func_count && strcmp( rec->funcs[ rec->func_last ].name, name ) == 0 )
+      return rec->func_last;
+
+   for( HB_SIZE i = 0; i < rec->func_count; ++i )
+   {
+      if( strcmp( rec->funcs[ i ].name, name ) == 0 )
+      {
+         rec->func_last = i;
+         return i;
+      }
+   }
+
+   if( rec->func_count == rec->func_capacity )
+   {
+      rec->func_capacity = rec->func_capacity ? rec->func_capacity * 2 : 32;
+      rec->funcs = ( SVG_RECORD_FUNC * ) hb_xrealloc( rec->funcs, rec->func_capacity * sizeof( SVG_RECORD_FUNC ) );
+   }
+
+   SVG_RECORD_FUNC *func = &rec->funcs[ rec->func_count ];
+
+   memset( func, 0, sizeof( SVG_RECORD_FUNC ) );
+   func->name = hb_strdup( name );
+
+   svg_buffer_reserve( &rec->out, 1 );
+   svg_record_byte( rec, SVG_REC_FUNC );
+   svg_record_bytes( rec, name, strlen( name ) );
+
+   rec->func_last = rec->func_count++;
+   return rec->func_last;
+}
+
+static void svg_record_grow_strings( SVG_RECORDER *rec )
+{
+   HB_SIZE capacity = rec->string_capacity ? rec->string_capacity * 2 : 256;
+   SVG_RECORD_STRING *strings = ( SVG_RECORD_STRING * ) hb_xgrab( capacity * sizeof( SVG_RECORD_STRING ) );
+
+   memset( strings, 0, capacity * sizeof( SVG_RECORD_STRING ) );
+
+   for( HB_SIZE i = 0; i < rec->string_capacity; ++i )
+   {
+      if( rec->strings[ i ].id )
+      {
+         HB_SIZE slot = ( HB_SIZE ) rec->strings[ i ].hash & ( capacity - 1 );
+
+         while( strings[ slot ].id )
+         {
+            slot = ( slot + 1 ) & ( capacity - 1 );
+         }
+         strings[ slot ] = rec->strings[ i ];
+      }
+   }
+
+   if( rec->strings )
+   {
+      hb_xfree( rec->strings );
+   }
+   rec->strings = strings;
+   rec->string_capacity = capacity;
+}
+
+static void svg_record_string( SVG_RECORDER *rec, const char *data, HB_SIZE len )
+{
+   if( len > SVG_RECORD_INTERN )
+   {
+      svg_buffer_reserve( &rec->out, 1 );
+      svg_record_byte( rec, SVG_ARG_BLOB );
+      svg_record_bytes( rec, data, len );
+      return;
+   }
+
+   // Kept at most half full
+   if( ( rec->string_count + 1 ) * 2 > rec->string_capacity )
+   {
+      svg_record_grow_strings( rec );
+   }
+
+   HB_U64 hash = svg_hash_bytes( 0, data, len );
+   HB_SIZE slot = ( HB_SIZE ) hash & ( rec->string_capacity - 1 );
+
+   while( rec->strings[ slot ].id )
+   {
+      SVG_RECORD_STRING *string = &rec->strings[ slot ];
+
+      if( string->hash == hash && string->len == len && memcmp( string->data, data, len ) == 0 )
+      {
+         svg_buffer_reserve( &rec->out, 16 );
+         svg_record_byte( rec, SVG_ARG_STRING );
+         svg_record_varint( rec, string->id - 1 );
+         return;
+      }
+      slot = ( slot + 1 ) & ( rec->string_capacity - 1 );
+   }
+
+   SVG_RECORD_STRING *string = &rec->strings[ slot ];
+
+   string->hash = hash;
+   string->id = ( HB_U32 ) ++rec->string_count;
+   string->len = ( HB_U32 ) len;
+   string->data = ( char * ) hb_xgrab( len + 1 );
+   memcpy( string->data, data, len );
+
+   svg_buffer_reserve( &rec->out, 1 );
+   svg_record_byte( rec, SVG_ARG_NEWSTR );
+   svg_record_bytes( rec, data, len );
+}
+
+/* last is the delta base of the argument, NULL for none */
+static void svg_record_item( SVG_RECORDER *rec, PHB_ITEM pItem, HB_I64 *last )
+{
+   svg_buffer_reserve( &rec->out, 16 );
+
+   if( pItem == NULL || HB_IS_NIL( pItem ) )
+   {
+      svg_record_byte( rec, SVG_ARG_NIL );
+   }
+   else if( HB_IS_NUMERIC( pItem ) )
+   {
+      double value = hb_itemGetND( pItem );
+
+      // Whole numbers that survive the round trip through HB_I64 exactly
+      if( fabs( value ) < 9007199254740992.0 && value == ( double ) ( HB_I64 ) value && ! ( value == 0 && signbit( value ) ) )
+      {
+         HB_I64 base = last ? *last : 0;
+         HB_I64 delta = ( HB_I64 ) value - base;
+
+         svg_record_byte( rec, SVG_ARG_INT );
+         svg_record_varint( rec, ( ( HB_U64 ) delta << 1 ) ^ ( HB_U64 ) ( delta >> 63 ) );
+         if( last )
+         {
+            *last = ( HB_I64 ) value;
+         }
+      }
+      else
+      {
+         svg_record_byte( rec, SVG_ARG_DOUBLE );
+         memcpy( rec->out.data + rec->out.len, &value, 8 );
+         rec->out.len += 8;
+      }
+   }
+   else if( HB_IS_STRING( pItem ) )
+   {
+      svg_record_string( rec, hb_itemGetCPtr( pItem ), hb_itemGetCLen( pItem ) );
+   }
+   else if( HB_IS_LOGICAL( pItem ) )
+   {
+      svg_record_byte( rec, hb_itemGetL( pItem ) ? SVG_ARG_TRUE : SVG_ARG_FALSE );
+   }
+   else if( HB_IS_HASH( pItem ) )
+   {
+      HB_SIZE len = hb_hashLen( pItem );
+
+      svg_record_byte( rec, SVG_ARG_HASH );
+      svg_record_varint( rec, len );
+      for( HB_SIZE i = 1; i <= len; ++i )
+      {
+         svg_record_item( rec, hb_hashGetKeyAt( pItem, i ), NULL );
+         svg_record_item( rec, hb_hashGetValueAt( pItem, i ), NULL );
+      }
+   }
+   else if( HB_IS_ARRAY( pItem ) )
+   {
+      HB_SIZE len = hb_arrayLen( pItem );
+      HB_I64 pair[ 2 ] = { 0, 0 };
+
+      svg_record_byte( rec, SVG_ARG_ARRAY );
+      svg_record_varint( rec, len );
+      for( HB_SIZE i = 1; i <= len; ++i )
+      {
+         svg_record_item( rec, hb_arrayGetItemPtr( pItem, i ), &pair[ ( i - 1 ) & 1 ] );
+      }
+   }
+   else
+   {
+      // Pointers, blocks and objects cannot be stored, replay passes NIL
+      svg_record_byte( rec, SVG_ARG_NIL );
+   }
+}
+
+/* ------------------------------------------------------------------------- */
+/* Creates binfile and writes its header, NULL when it cannot be created */
+SVG_RECORDER *svg_recorder_new( const char *binfile, int width, int height, int flags )
+{
+   FILE *file = fopen( binfile, "wb" );
+
+   if( file == NULL )
+   {
+      fprintf( stderr, "Error: Could not open file '%s' for writing.\n", binfile );
+      return NULL;
+   }
+
+   SVG_RECORDER *rec = ( SVG_RECORDER * ) hb_xgrab( sizeof( SVG_RECORDER ) );
+
+   memset( rec, 0, sizeof( SVG_RECORDER ) );
+   rec->file = file;
+
+   svg_buffer_reserve( &rec->out, SVG_RECORD_FLUSH + 1024 );
+   memcpy( rec->out.data, SVG_RECORD_MAGIC, 8 );
+   rec->out.len = 8;
+   svg_record_varint( rec, ( HB_U64 ) ( HB_U32 ) width );
+   svg_record_varint( rec, ( HB_U64 ) ( HB_U32 ) height );
+   svg_record_varint( rec, ( HB_U64 ) ( HB_U32 ) flags );
+
+   return rec;
+}
+
+/* Records the current function and its arguments; the first one is the handle.
+   With markup, argument 2 is replaced by it and argument 6 by .T. ( svg_import() ) */
+static void svg_record_call( SVG_RECORDER *rec, const char *markup, HB_SIZE markup_len )
+{
+   char name[ HB_SYMBOL_NAME_LEN + HB_SYMBOL_NAME_LEN + 5 ];
+   int count = markup ? 6 : hb_pcount();
+   HB_SIZE id;
+
+   hb_procname( 0, name, HB_FALSE );
+   id = svg_record_func( rec, name );
+
+   if( count > 255 )
+      count = 255;
+
+   svg_buffer_reserve( &rec->out, 32 );
+   svg_record_byte( rec, SVG_REC_CALL );
+   svg_record_varint( rec, id );
+   svg_record_varint( rec, ( HB_U64 ) count );
+
+   if( count >= 1 )
+   {
+      svg_record_byte( rec, SVG_ARG_HANDLE );
+   }
+
+   SVG_RECORD_FUNC *func = &rec->funcs[ id ];
+
+   for( int i = 2; i <= count; ++i )
+   {
+      if( markup && i == 2 )
+      {
+         svg_buffer_reserve( &rec->out, 1 );
+         svg_record_byte( rec, SVG_ARG_BLOB );
+         svg_record_bytes( rec, markup, markup_len );
+      }
+      else if( markup && i == 6 )
+      {
+         svg_buffer_reserve( &rec->out, 1 );
+         svg_record_byte( rec, SVG_ARG_TRUE );
+      }
+      else
+      {
+         svg_record_item( rec, hb_param( i, HB_IT_ANY ), i - 2 < SVG_RECORD_SLOTS ? &func->last[ i - 2 ] : NULL );
+      }
+   }
+
+   if( rec->out.len >= SVG_RECORD_FLUSH )
+   {
+      svg_record_flush( rec );
+   }
+}
+
+/* Drawing functions call it after checking their arguments, queries never do */
+void svg_recorder_call( SVG_RECORDER *rec )
+{
+   svg_record_call( rec, NULL, 0 );
+}
+
+/* Records the current svg_import() call with the template markup in place of
+   its file name, so replay does not depend on the file */
+void svg_recorder_template( SVG_RECORDER *rec, const char *data, HB_SIZE len )
+{
+   svg_record_call( rec, data, len );
+}
+
+/* Writes the end record and releases the recorder. Returns F when any write failed. */
+bool svg_recorder_close( SVG_RECORDER *rec )
+{
+   bool ok;
+
+   svg_buffer_reserve( &rec->out, 1 );
+   svg_record_byte( rec, SVG_REC_END );
+   svg_record_flush( rec );
+
+   ok = fclose( rec->file ) == 0 && ! rec->error;
+
+   for( HB_SIZE i = 0; i < rec->func_count; ++i )
+   {
+      hb_xfree( rec->funcs[ i ].name );
+   }
+   if( rec->funcs )
+   {
+      hb_xfree( rec->funcs );
+   }
+
+   for( HB_SIZE i = 0; i < rec->string_capacity; ++i )
+   {
+      if( rec->strings[ i ].id )
+      {
+         hb_xfree( rec->strings[ i ].data );
+      }
+   }
+   if( rec->strings )
+   {
+      hb_xfree( rec->strings );
+   }
+
+   svg_buffer_free( &rec->out );
+   hb_xfree( rec );
+
+   return ok;
+}
+
+/* ------------------------------------------------------------------------- */
+// Replay
+typedef struct
+{
+   const char *name;
+   HB_SIZE len;
+} SVG_REPLAY_STRING;
+
+typedef struct
+{
+   const HB_BYTE *p;
+   const HB_BYTE *end;
+   bool error;                // malformed or truncated input
+
+   PHB_DYNS *funcs;
+   HB_I64 ( *last )[ SVG_RECORD_SLOTS ];
+   HB_SIZE func_count;
+   HB_SIZE func_capacity;
+
+   SVG_REPLAY_STRING *strings;   // views into the mapped file
+   HB_SIZE string_count;
+   HB_SIZE string_capacity;
+} SVG_REPLAY;
+
+static HB_U64 svg_replay_varint( SVG_REPLAY *r )
+{
+   HB_U64 value = 0;
+   int shift = 0;
+
+   while( r->p < r->end )
+   {
+      HB_BYTE byte = *r->p++;
+
+      value |= ( HB_U64 ) ( byte & 0x7F ) << shift;
+      if( byte < 0x80 )
+         return value;
+
+      shift += 7;
+      if( shift > 63 )
+         break;
+   }
+
+   r->error = T;
+   return 0;
+}
+
+/* Length-prefixed bytes, NULL when they run past the end */
+static const char *svg_replay_bytes( SVG_REPLAY *r, HB_SIZE *len )
+{
+   HB_U64 size = svg_replay_varint( r );
+
+   if( r->error || size > ( HB_U64 ) ( r->end - r->p ) )
+   {
+      r->error = T;
+      return NULL;
+   }
+
+   const char *data = ( const char * ) r->p;
+
+   r->p += size;
+   *len = ( HB_SIZE ) size;
+   return data;
+}
+
+static void svg_replay_item( SVG_REPLAY *r, PHB_ITEM pItem, PHB_ITEM pHandle, HB_I64 *last, int depth )
+{
+   if( r->p >= r->end || depth > 64 )
+   {
+      r->error = T;
+      hb_itemClear( pItem );
+      return;
+   }
+
+   switch( *r->p++ )
+   {
+      case SVG_ARG_NIL:
+         hb_itemClear( pItem );
+         break;
+
+      case SVG_ARG_HANDLE:
+         // Only valid as the first argument of a call
+         if( pHandle )
+         {
+            hb_itemCopy( pItem, pHandle );
+         }
+         else
+         {
+            r->error = T;
+            hb_itemClear( pItem );
+         }
+         break;
+
+      case SVG_ARG_INT:
+      {
+         HB_U64 zigzag = svg_replay_varint( r );
+         HB_I64 value = ( last ? *last : 0 ) + ( HB_I64 ) ( ( zigzag >> 1 ) ^ ( ~( zigzag & 1 ) + 1 ) );
+
+         if( last )
+         {
+            *last = value;
+         }
+         hb_itemPutNInt( pItem, value );
+         break;
+      }
+
+      case SVG_ARG_DOUBLE:
+      {
+         double value;
+
+         if( r->end - r->p < 8 )
+         {
+            r->error = T;
+            hb_itemClear( pItem );
+            break;
+         }
+         memcpy( &value, r->p, 8 );
+         r->p += 8;
+         hb_itemPutND( pItem, value );
+         break;
+      }
+
+      case SVG_ARG_STRING:
+      {
+         HB_U64 id = svg_replay_varint( r );
+
+         if( id < r->string_count )
+         {
+            hb_itemPutCL( pItem, r->strings[ id ].name, r->strings[ id ].len );
+         }
+         else
+         {
+            r->error = T;
+            hb_itemClear( pItem );
+         }
+         break;
+      }
+
+      case SVG_ARG_NEWSTR:
+      case SVG_ARG_BLOB:
+      {
+         bool intern = r->p[ -1 ] == SVG_ARG_NEWSTR;
+         HB_SIZE len = 0;
+         const char *data = svg_replay_bytes( r, &len );
+
+         if( data == NULL )
+         {
+            hb_itemClear( pItem );
+            break;
+         }
+
+         if( intern )
+         {
+            if( r->string_count == r->string_capacity )
+            {
+               r->string_capacity = r->string_capacity ? r->string_capacity * 2 : 256;
+               r->strings = ( SVG_REPLAY_STRING * ) hb_xrealloc( r->strings, r->string_capacity * sizeof( SVG_REPLAY_STRING ) );
+            }
+            r->strings[ r->string_count ].name = data;
+            r->strings[ r->string_count ].len = len;
+            r->string_count++;
+         }
+         hb_itemPutCL( pItem, data, len );
+         break;
+      }
+
+      case SVG_ARG_FALSE:
+      case SVG_ARG_TRUE:
+         hb_itemPutL( pItem, r->p[ -1 ] == SVG_ARG_TRUE );
+         break;
+
+      case SVG_ARG_ARRAY:
+      {
+         HB_U64 len = svg_replay_varint( r );
+         HB_I64 pair[ 2 ] = { 0, 0 };
+
+         // Every element takes at least one byte
+         if( r->error || len > ( HB_U64 ) ( r->end - r->p ) )
+         {
+            r->error = T;
+            hb_itemClear( pItem );
+            break;
+         }
+
+         PHB_ITEM pElement = hb_itemNew( NULL );
+
+         hb_arrayNew( pItem, ( HB_SIZE ) len );
+         for( HB_SIZE i = 1; i <= len && ! r->error; ++i )
+         {
+            svg_replay_item( r, pElement, NULL, &pair[ ( i - 1 ) & 1 ], depth + 1 );
+            hb_arraySet( pItem, i, pElement );
+         }
+         hb_itemRelease( pElement );
+         break;
+      }
+
+      case SVG_ARG_HASH:
+      {
+         HB_U64 len = svg_replay_varint( r );
+
+         if( r->error || len > ( HB_U64 ) ( r->end - r->p ) / 2 )
+         {
+            r->error = T;
+            hb_itemClear( pItem );
+            break;
+         }
+
+         PHB_ITEM pKey = hb_itemNew( NULL );
+         PHB_ITEM pValue = hb_itemNew( NULL );
+
+         hb_hashNew( pItem );
+         for( HB_SIZE i = 1; i <= len && ! r->error; ++i )
+         {
+            svg_replay_item( r, pKey, NULL, NULL, depth + 1 );
+            svg_replay_item( r, pValue, NULL, NULL, depth + 1 );
+            hb_hashAdd( pItem, pKey, pValue );
+         }
+         hb_itemRelease( pValue );
+         hb_itemRelease( pKey );
+         break;
+      }
+
+      default:
+         r->error = T;
+         hb_itemClear( pItem );
+         break;
+   }
+}
+
+static PHB_DYNS svg_replay_symbol( const char *name, HB_SIZE len )
+{
+   char buffer[ HB_SYMBOL_NAME_LEN + HB_SYMBOL_NAME_LEN + 5 ];
+
+   if( len == 0 || len >= sizeof( buffer ) )
+      return NULL;
+
+   memcpy( buffer, name, len );
+   buffer[ len ] = '\0';
+
+   return hb_dynsymFindName( buffer );
+}
+
+/* The return value is left in hb_param( -1 ) */
+static void svg_replay_proc( PHB_DYNS symbol, PHB_ITEM *args, int count )
+{
+   hb_vmPushDynSym( symbol );
+   hb_vmPushNil();
+   for( int i = 0; i < count; ++i )
+   {
+      hb_vmPush( args[ i ] );
+   }
+   hb_vmProc( ( HB_USHORT ) count );
+}
+
+/* ------------------------------------------------------------------------- */
+/* Writes svgfile from the calls recorded in binfile. Returns F when binfile
+   is missing or malformed, names a function that is not in s_replayable or
+   not linked in, or the document cannot be written. */
+bool svg_replay_file( const char *binfile, const char *svgfile )
+{
+   PHB_DYNS symInit = hb_dynsymFindName( "SVG_INIT" );
+   PHB_DYNS symClose = hb_dynsymFindName( "SVG_CLOSE" );
+   HB_SIZE size = 0;
+   const char *data = svg_file_map( binfile, &size );
+
+   if( data == NULL )
+   {
+      fprintf( stderr, "Error: Could not open file '%s' for reading.\n", binfile );
+      return F;
+   }
+
+   if( symInit == NULL || symClose == NULL || size < 8 || memcmp( data, SVG_RECORD_MAGIC, 8 ) != 0 )
+   {
+      fprintf( stderr, "Error: '%s' is not a recorded document.\n", binfile );
+      svg_file_unmap( data, size );
+      return F;
+   }
+
+   SVG_REPLAY r;
+   PHB_ITEM args[ 255 ];
+   bool ok = T;
+
+   memset( &r, 0, sizeof( SVG_REPLAY ) );
+   r.p = ( const HB_BYTE * ) data + 8;
+   r.end = ( const HB_BYTE * ) data + size;
+
+   HB_U64 width = svg_replay_varint( &r );
+   HB_U64 height = svg_replay_varint( &r );
+   HB_U64 flags = svg_replay_varint( &r );
+
+   for( int i = 0; i < 255; ++i )
+   {
+      args[ i ] = NULL;
+   }
+   args[ 0 ] = hb_itemPutC( hb_itemNew( NULL ), svgfile );
+   args[ 1 ] = hb_itemPutNInt( hb_itemNew( NULL ), ( HB_I32 ) width );
+   args[ 2 ] = hb_itemPutNInt( hb_itemNew( NULL ), ( HB_I32 ) height );
+   args[ 3 ] = hb_itemPutNInt( hb_itemNew( NULL ), ( HB_I32 ) flags );
+
+   svg_replay_proc( symInit, args, 4 );
+
+   PHB_ITEM pHandle = hb_itemNew( hb_param( -1, HB_IT_ANY ) );
+
+   if( r.error || ! HB_IS_POINTER( pHandle ) )
+   {
+      ok = F;
+   }
+
+   while( ok )
+   {
+      if( r.p >= r.end || hb_vmRequestQuery() )
+      {
+         // Truncated recording: the document is closed, but reported as failed
+         ok = F;
+         break;
+      }
+
+      HB_BYTE tag = *r.p++;
+
+      if( tag == SVG_REC_CALL )
+      {
+         HB_U64 id = svg_replay_varint( &r );
+         HB_U64 count = svg_replay_varint( &r );
+
+         // Every call is made on the replayed handle
+         if( r.error || id >= r.func_count || count < 1 || count > 255 || r.p >= r.end || *r.p != SVG_ARG_HANDLE )
+         {
+            ok = F;
+            break;
+         }
+
+         for( HB_SIZE i = 0; i < count; ++i )
+         {
+            if( args[ i ] == NULL )
+            {
+               args[ i ] = hb_itemNew( NULL );
+            }
+            svg_replay_item( &r, args[ i ], i == 0 ? pHandle : NULL, i >= 1 && i - 1 < SVG_RECORD_SLOTS ? &r.last[ id ][ i - 1 ] : NULL, 0 );
+         }
+
+         if( r.error )
+         {
+            ok = F;
+            break;
+         }
+
+         svg_replay_proc( r.funcs[ id ], args, ( int ) count );
+      }
+      else if( tag == SVG_REC_FUNC )
+      {
+         HB_SIZE len = 0;
+         const char *name = svg_replay_bytes( &r, &len );
+         PHB_DYNS symbol = NULL;
+
+         if( name && ! svg_replayable( name, len ) )
+         {
+            fprintf( stderr, "Error: Recorded function '%.*s' cannot be replayed.\n", ( int ) len, name );
+            ok = F;
+            break;
+         }
+
+         symbol = name ? svg_replay_symbol( name, len ) : NULL;
+
+         if( symbol == NULL )
+         {
+            if( name )
+            {
+               fprintf( stderr, "Error: Recorded function '%.*s' is not available.\n", ( int ) len, name );
+            }
+            ok = F;
+            break;
+         }
+
+         if( r.func_count == r.func_capacity )
+         {
+            r.func_capacity = r.func_capacity ? r.func_capacity * 2 : 32;
+            r.funcs = ( PHB_DYNS * ) hb_xrealloc( r.funcs, r.func_capacity * sizeof( PHB_DYNS ) );
+            r.last = ( HB_I64 ( * )[ SVG_RECORD_SLOTS ] ) hb_xrealloc( r.last, r.func_capacity * sizeof( r.last[ 0 ] ) );
+         }
+         r.funcs[ r.func_count ] = symbol;
+         memset( r.last[ r.func_count ], 0, sizeof( r.last[ 0 ] ) );
+         r.func_count++;
+      }
+      else if( tag == SVG_REC_END )
+      {
+         break;
+      }
+      else
+      {
+         ok = F;
+      }
+   }
+
+   if( ! ok )
+   {
+      fprintf( stderr, "Error: '%s' is truncated or malformed.\n", binfile );
+   }
+
+   if( HB_IS_POINTER( pHandle ) )
+   {
+      svg_replay_proc( symClose, &pHandle, 1 );
+      if( ! hb_itemGetL( hb_param( -1, HB_IT_ANY ) ) )
+      {
+         ok = F;
+      }
+   }
+
+   for( int i = 0; i < 255 && args[ i ]; ++i )
+   {
+      hb_itemRelease( args[ i ] );
+   }
+   hb_itemRelease( pHandle );
+
+   if( r.funcs )
+   {
+      hb_xfree( r.funcs );
+      hb_xfree( r.last );
+   }
+   if( r.strings )
+   {
+      hb_xfree( r.strings );
+   }
+   svg_file_unmap( data, size );
+
+   return ok;
+}
@@ -0,0 +1,261 @@
+/*
+ * Harbour Scalable Vector Graphics (HBSVG) Project
+ * Copyright 2014 - 2024 Rafał Jopek
+ * Website: https://harbour.pl
+ *
+ */
+
+/*
+ * Tiled output.
+ *
+ * The canvas is cut into a pyramid of square tiles. Level levels - 1 is the
+ * full-resolution level, every lower level covers the same canvas at half
+ * the scale of the level above it. Tile files are named
+ * <prefix><level>_<column>_<row>.svg and keep the canvas coordinates of the
+ * elements; only their viewBox differs.
+ *
+ * Each element is buffered while it is written and then appended to the
+ * pending output of every tile its bounding box intersects. Pending output
+ * is flushed to the tile files when a tile or the whole pyramid exceeds its
+ * budget, so the number of open files and the memory use stay bounded.
+ */
+
+#include "hbsvg.h"
+
+#define SVG_TILE_FLUSH       0x10000     // pending bytes of one tile
+#define SVG_TILES_FLUSH      0x2000000   // pending bytes of the whole pyramid
+
+/* ------------------------------------------------------------------------- */
+// static
+static double svg_tiles_scale( SVG_TILES *tiles, int level )
+{
+   return ldexp( 1.0, level - ( tiles->levels - 1 ) );
+}
+
+static bool svg_tile_flush( SVG_TILES *tiles, int level, int col, int row, bool close )
+{
+   SVG_TILE *tile = &tiles->tiles[ level ][ row * tiles->cols[ level ] + col ];
+   char *filename;
+   FILE *file;
+   bool ok = T;
+
+   if( tile->pending.len == 0 && ! close )
+      return T;
+
+   filename = ( char * ) hb_xgrab( strlen( tiles->prefix ) + 40 );
+   sprintf( filename, "%s%d_%d_%d.svg", tiles->prefix, level, col, row );
+
+   file = fopen( filename, tile->created ? "ab" : "wb" );
+   if( file == NULL )
+   {
+      fprintf( stderr, "Error: Could not open file '%s' for writing.\n", filename );
+      hb_xfree( filename );
+
+      // The tile is lost already; keeping its output would only retry the open on every flush
+      tiles->pending -= tile->pending.len;
+      if( close )
+      {
+         svg_buffer_free( &tile->pending );
+      }
+      else
+      {
+         tile->pending.len = 0;
+      }
+      tiles->error = T;
+      return F;
+   }
+
+   if( ! tile->created )
+   {
+      double span = tiles->tile_size / svg_tiles_scale( tiles, level );
+
+      if( ! tiles->minify )
+      {
+         fprintf( file, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n" );
+         fprintf( file, "<!DOCTYPE svg PUBLIC \"-//W3C//DTD SVG 1.1//EN\" " );
+         fprintf( file, "\"http://www.w3.org/Graphics/SVG/1.1/DTD/svg11.dtd\">\n" );
+      }
+      fprintf( file, "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%d\" height=\"%d\" viewBox=\"%g %g %g %g\">%s",
+               tiles->tile_size, tiles->tile_size, col * span, row * span, span, span, tiles->minify ? "" : "\n" );
+      tile->created = T;
+   }
+
+   if( tile->pending.len )
+   {
+      ok = fwrite( tile->pending.data, 1, tile->pending.len, file ) == tile->pending.len;
+      tiles->pending -= tile->pending.len;
+   }
+
+   if( close )
+   {
+      fprintf( file, "</svg>" );
+      svg_buffer_free( &tile->pending );
+   }
+   else
+   {
+      tile->pending.len = 0;
+   }
+
+   if( fclose( file ) != 0 )
+      ok = F;
+
+   if( ! ok )
+      tiles->error = T;
+
+   hb_xfree( filename );
+   return ok;
+}
+
+/* Appends the buffered element to the tiles it intersects */
+static void svg_tiles_route( SVG_TILES *tiles )
+{
+   if( tiles->element.len == 0 )
+      return;
+
+   for( int level = 0; level < tiles->levels; ++level )
+   {
+      double scale = svg_tiles_scale( tiles, level );
+      double span = tiles->tile_size / scale;
+      int col0 = 0, row0 = 0;
+      int col1 = tiles->cols[ level ] - 1;
+      int row1 = tiles->rows[ level ] - 1;
+
+      if( tiles->bounded )
+      {
+         const SVG_BOX *box = &tiles->box;
+
+         // Elements smaller than a pixel are not visible on the lower levels
+         if( level < tiles->levels - 1 &&
+             ( box->x1 - box->x0 ) * scale < 1 && ( box->y1 - box->y0 ) * scale < 1 )
+            continue;
+
+         if( box->x1 < 0 || box->y1 < 0 || box->x0 > tiles->width || box->y0 > tiles->height )
+            continue;
+
+         if( box->x0 > 0 ) col0 = ( int ) ( box->x0 / span );
+         if( box->y0 > 0 ) row0 = ( int ) ( box->y0 / span );
+         if( ( int ) ( box->x1 / span ) < col1 ) col1 = ( int ) ( box->x1 / span );
+         if( ( int ) ( box->y1 / span ) < row1 ) row1 = ( int ) ( box->y1 / span );
+      }
+
+      for( int row = row0; row <= row1; ++row )
+      {
+         for( int col = col0; col <= col1; ++col )
+         {
+            SVG_TILE *tile = &tiles->tiles[ level ][ row * tiles->cols[ level ] + col ];
+
+            svg_buffer_append( &tile->pending, tiles->element.data, tiles->element.len );
+            tiles->pending += tiles->element.len;
+
+            if( tile->pending.len >= SVG_TILE_FLUSH )
+            {
+               svg_tile_flush( tiles, level, col, row, F );
+            }
+         }
+      }
+   }
+
+   tiles->element.len = 0;
+
+   // Keep the pyramid within its memory budget
+   if( tiles->pending >= SVG_TILES_FLUSH )
+   {
+      for( int level = 0; level < tiles->levels; ++level )
+      {
+         for( int row = 0; row < tiles->rows[ level ]; ++row )
+         {
+            for( int col = 0; col < tiles->cols[ level ]; ++col )
+            {
+               svg_tile_flush( tiles, level, col, row, F );
+            }
+         }
+      }
+   }
+}
+
+/* ------------------------------------------------------------------------- */
+SVG_TILES *svg_tiles_new( const char *prefix, int width, int height, int tile_size, int levels, bool minify )
+{
+   SVG_TILES *tiles = ( SVG_TILES * ) hb_xgrab( sizeof( SVG_TILES ) );
+
+   memset( tiles, 0, sizeof( SVG_TILES ) );
+
+   tiles->prefix = hb_strdup( prefix );
+   tiles->width = width;
+   tiles->height = height;
+   tiles->tile_size = tile_size;
+   tiles->levels = levels;
+   tiles->minify = minify;
+   tiles->cols = ( int * ) hb_xgrab( levels * sizeof( int ) );
+   tiles->rows = ( int * ) hb_xgrab( levels * sizeof( int ) );
+   tiles->tiles = ( SVG_TILE ** ) hb_xgrab( levels * sizeof( SVG_TILE * ) );
+
+   for( int level = 0; level < levels; ++level )
+   {
+      double span = tile_size / svg_tiles_scale( tiles, level );
+      int cols = ( int ) ceil( width / span );
+      int rows = ( int ) ceil( height / span );
+
+      tiles->cols[ level ] = cols > 0 ? cols : 1;
+      tiles->rows[ level ] = rows > 0 ? rows : 1;
+      tiles->tiles[ level ] = ( SVG_TILE * ) hb_xgrab( tiles->cols[ level ] * tiles->rows[ level ] * sizeof( SVG_TILE ) );
+      memset( tiles->tiles[ level ], 0, tiles->cols[ level ] * tiles->rows[ level ] * sizeof( SVG_TILE ) );
+   }
+
+   return tiles;
+}
+
+/* Starts a new element; box is NULL for output that belongs to every tile */
+void svg_tiles_element( SVG_TILES *tiles, const SVG_BOX *box )
+{
+   svg_tiles_route( tiles );
+
+   if( box )
+   {
+      tiles->box = *box;
+      tiles->bounded = T;
+   }
+   else
+   {
+      tiles->bounded = F;
+   }
+}
+
+/* Sets the box of the current element once its extent is known */
+void svg_tiles_bound( SVG_TILES *tiles, const SVG_BOX *box )
+{
+   tiles->box = *box;
+   tiles->bounded = T;
+}
+
+/* Writes the remaining output of every tile, then releases the pyramid.
+   Returns F when any tile could not be written, now or by an earlier flush. */
+bool svg_tiles_close( SVG_TILES *tiles )
+{
+   bool ok;
+
+   svg_tiles_route( tiles );
+
+   for( int level = 0; level < tiles->levels; ++level )
+   {
+      for( int row = 0; row < tiles->rows[ level ]; ++row )
+      {
+         for( int col = 0; col < tiles->cols[ level ]; ++col )
+         {
+            svg_tile_flush( tiles, level, col, row, T );
+         }
+      }
+      hb_xfree( tiles->tiles[ level ] );
+   }
+
+   ok = ! tiles->error;
+
+   svg_buffer_free( &tiles->element );
+   hb_xfree( tiles->tiles );
+   hb_xfree( tiles->cols );
+   hb_xfree( tiles->rows );
+   hb_xfree( tiles->prefix );
+   hb_xfree( tiles );
+
+   return ok;
+}
@@ -0,0 +1,230 @@
+/*
+ * Harbour Scalable Vector Graphics (HBSVG) Project
+ * Copyright 2014 - 2024 Rafał Jopek
+ * Website: https://harbour.pl
+ *
+ */
+
+/*
+ * Asynchronous writer.
+ *
+ * A handle opened with SVG_FLAG_ASYNC hands every full output buffer to a
+ * native thread and goes on formatting into an empty one. The thread writes
+ * all buffers queued at the time at once ( a single writev() where
+ * available ), so formatting and disk or network I/O overlap. When all
+ * SVG_WRITER_BUFFERS are queued the drawing thread waits for the writer,
+ * which bounds the memory in flight.
+ *
+ * The thread is started with Harbour's portable thread API. It never calls
+ * into the VM: buffers are allocated and released by the thread owning the
+ * handle only. All writers share one mutex and two conditions; the state
+ * they guard is per writer, so waiters are woken by broadcasts.
+ */
+
+#include "hbsvg.h"
+
+#if defined( HB_OS_UNIX )
+   #include <errno.h>
+   #include <sys/uio.h>
+   #include <unistd.h>
+#endif
+
+#define SVG_WRITER_BUFFERS  4
+
+struct _SVG_WRITER
+{
+   FILE *file;
+   HB_THREAD_ID id;
+   HB_THREAD_HANDLE thread;
+   SVG_BUFFER buffers[ SVG_WRITER_BUFFERS ];
+   int head;                  // first queued buffer
+   int count;                 // queued buffers
+   bool quit;
+   bool error;
+};
+
+static HB_CRITICAL_NEW( s_writerMtx );
+static HB_COND_NEW( s_writerQueued );     // signalled by drawing threads
+static HB_COND_NEW( s_writerWritten );    // signalled by writer threads
+
+/* ------------------------------------------------------------------------- */
+// static
+#if defined( HB_OS_UNIX )
+
+static bool svg_writer_write( SVG_WRITER *writer, SVG_BUFFER **buffers, int count )
+{
+   struct iovec vec[ SVG_WRITER_BUFFERS ];
+   struct iovec *iov = vec;
+   int fd = fileno( writer->file );
+
+   for( int i = 0; i < count; ++i )
+   {
+      vec[ i ].iov_base = buffers[ i ]->data;
+      vec[ i ].iov_len = buffers[ i ]->len;
+   }
+
+   while( count > 0 )
+   {
+      ssize_t written = writev( fd, iov, count );
+
+      if( written < 0 )
+      {
+         if( errno == EINTR )
+            continue;
+         return F;
+      }
+
+      // Partial write: skip what is done and retry the rest
+      while( count > 0 && ( size_t ) written >= iov->iov_len )
+      {
+         written -= iov->iov_len;
+         iov++;
+         count--;
+      }
+      if( count > 0 )
+      {
+         iov->iov_base = ( char * ) iov->iov_base + written;
+         iov->iov_len -= written;
+      }
+   }
+
+   return T;
+}
+
+#else
+
+/* The file is unbuffered, each buffer goes out in one call */
+static bool svg_writer_write( SVG_WRITER *writer, SVG_BUFFER **buffers, int count )
+{
+   for( int i = 0; i < count; ++i )
+   {
+      if( fwrite( buffers[ i ]->data, 1, buffers[ i ]->len, writer->file ) != buffers[ i ]->len )
+         return F;
+   }
+
+   return T;
+}
+
+#endif
+
+static HB_THREAD_STARTFUNC( svg_writer_thread )
+{
+   SVG_WRITER *writer = ( SVG_WRITER * ) Cargo;
+   SVG_BUFFER *buffers[ SVG_WRITER_BUFFERS ];
+
+   hb_threadEnterCriticalSection( &s_writerMtx );
+   for( ;; )
+   {
+      while( writer->count == 0 && ! writer->quit )
+      {
+         hb_threadCondWait( &s_writerQueued, &s_writerMtx );
+      }
+
+      if( writer->count == 0 )
+         break;
+
+      // Everything queued so far goes out at once, new buffers queue behind it
+      int head = writer->head;
+      int count = writer->count;
+      bool error = writer->error;
+
+      hb_threadLeaveCriticalSection( &s_writerMtx );
+
+      for( int i = 0; i < count; ++i )
+      {
+         buffers[ i ] = &writer->buffers[ ( head + i ) % SVG_WRITER_BUFFERS ];
+      }
+
+      // After an error the remaining output is dropped
+      if( ! error && ! svg_writer_write( writer, buffers, count ) )
+      {
+         error = T;
+      }
+
+      hb_threadEnterCriticalSection( &s_writerMtx );
+      for( int i = 0; i < count; ++i )
+      {
+         buffers[ i ]->len = 0;
+      }
+      writer->head = ( head + count ) % SVG_WRITER_BUFFERS;
+      writer->count -= count;
+      writer->error = error;
+      hb_threadCondBroadcast( &s_writerWritten );
+   }
+   hb_threadLeaveCriticalSection( &s_writerMtx );
+
+   HB_THREAD_END
+}
+
+/* ------------------------------------------------------------------------- */
+/* Starts a writer for an unbuffered file, NULL when no thread is available */
+SVG_WRITER *svg_writer_new( FILE *file )
+{
+   SVG_WRITER *writer = ( SVG_WRITER * ) hb_xgrab( sizeof( SVG_WRITER ) );
+
+   memset( writer, 0, sizeof( SVG_WRITER ) );
+   writer->file = file;
+
+   writer->thread = hb_threadCreate( &writer->id, svg_writer_thread, writer );
+   if( ! writer->thread )
+   {
+      // The output is written synchronously then
+      hb_xfree( writer );
+      return NULL;
+   }
+
+   return writer;
+}
+
+/* Queues the contents of out and leaves an empty buffer in its place */
+void svg_writer_push( SVG_WRITER *writer, SVG_BUFFER *out )
+{
+   SVG_BUFFER empty;
+   HB_SIZE capacity = out->capacity;
+
+   hb_threadEnterCriticalSection( &s_writerMtx );
+   while( writer->count == SVG_WRITER_BUFFERS )
+   {
+      hb_threadCondWait( &s_writerWritten, &s_writerMtx );
+   }
+
+   SVG_BUFFER *slot = &writer->buffers[ ( writer->head + writer->count ) % SVG_WRITER_BUFFERS ];
+
+   empty = *slot;
+   *slot = *out;
+   writer->count++;
+   hb_threadCondBroadcast( &s_writerQueued );
+   hb_threadLeaveCriticalSection( &s_writerMtx );
+
+   // Formatting goes on in a buffer as large as the one just queued
+   *out = empty;
+   if( out->capacity < capacity )
+   {
+      svg_buffer_reserve( out, capacity );
+   }
+}
+
+/* Writes the queued output, stops the thread and releases the writer.
+   Returns F when any write failed. */
+bool svg_writer_close( SVG_WRITER *writer )
+{
+   bool ok;
+
+   hb_threadEnterCriticalSection( &s_writerMtx );
+   writer->quit = T;
+   hb_threadCondBroadcast( &s_writerQueued );
+   hb_threadLeaveCriticalSection( &s_writerMtx );
+
+   hb_threadJoin( writer->thread );
+
+   ok = ! writer->error;
+
+   for( int i = 0; i < SVG_WRITER_BUFFERS; ++i )
+   {
+      svg_buffer_free( &writer->buffers[ i ] );
+   }
+
+   hb_xfree( writer );
+
+   return ok;
+}